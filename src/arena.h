@@ -84,6 +84,22 @@ static inline void bump_destroy(struct bump_alloc *b)
     b->current = NULL;
 }
 
+/* Move every slab of src into dst (src is left empty).  The slabs are
+ * linked in front of dst's head so that live allocations in them are
+ * never handed out again by bump_alloc; they are rewound by the next
+ * bump_reset and freed by bump_destroy like any other dst slab.
+ * Used to keep per-worker scratch alive for the rest of a query. */
+static inline void bump_adopt(struct bump_alloc *dst, struct bump_alloc *src)
+{
+    if (!src->head) return;
+    struct bump_slab *tail = src->head;
+    while (tail->next) tail = tail->next;
+    tail->next = dst->head;
+    dst->head = src->head;
+    src->head = NULL;
+    src->current = NULL;
+}
+
 /* Allocate n bytes from the bump slab chain (8-byte aligned).
  * Never moves existing allocations. */
 static inline void *bump_alloc(struct bump_alloc *b, size_t n)
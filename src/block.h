@@ -12,11 +12,65 @@
  * A 4-column block is ~32 KB. */
 #define BLOCK_CAPACITY 1024
 
+/* ---- TEXT prefixes ----
+ *
+ * The first 8 bytes of a string, NUL-padded and packed big-endian, so that
+ * comparing two prefixes as integers orders the strings like strcmp.  Equal
+ * prefixes whose low byte is 0 mean equal strings (both end inside the
+ * prefix).  A prefix array beside the string pointers is a column-wise
+ * "German string": most equality and ordering decisions are made without
+ * dereferencing either string. */
+#define STR_PFX_LEN 8
+
+static inline uint64_t str_pfx_n(const char *s, size_t len)
+{
+    uint64_t p = 0;
+    size_t n = len < STR_PFX_LEN ? len : STR_PFX_LEN;
+    for (size_t i = 0; i < n; i++)
+        p |= (uint64_t)(uint8_t)s[i] << (56 - 8 * i);
+    return p;
+}
+
+static inline uint64_t str_pfx(const char *s)
+{
+    uint64_t p = 0;
+    for (size_t i = 0; s && i < STR_PFX_LEN && s[i]; i++)
+        p |= (uint64_t)(uint8_t)s[i] << (56 - 8 * i);
+    return p;
+}
+
+/* strcmp(sa, sb) given pa = str_pfx(sa), pb = str_pfx(sb) (sign only). */
+static inline int str_pfx_cmp(uint64_t pa, const char *sa, uint64_t pb, const char *sb)
+{
+    if (pa != pb) return pa < pb ? -1 : 1;
+    if (!(pa & 0xff)) return 0;
+    return strcmp(sa + STR_PFX_LEN, sb + STR_PFX_LEN);
+}
+
+/* Per-column dictionary of a low-cardinality TEXT column in table.flat
+ * (see "Dictionary-encoded TEXT" below). */
+struct flat_dict {
+    uint32_t   count;     /* distinct values interned */
+    uint32_t   cap;       /* allocated entries */
+    char     **strs;      /* [cap] owned, NUL-terminated */
+    uint32_t  *lens;      /* [cap] strlen(strs[i]) */
+    uint32_t  *hashes;    /* [cap] block_hash_str_n(strs[i], lens[i]) */
+    uint32_t  *slots;     /* [nslots] code + 1, 0 = empty (open addressing) */
+    uint32_t   nslots;    /* power of 2, >= 2 * cap */
+    int32_t   *codes;     /* [flat_table cap] code per row, -1 for NULL */
+};
+
 /* Column block: a contiguous typed array for a single column.
  * All data is bump-allocated from arena->scratch — no per-block free.
  * str_lens: bump-allocated uint32_t[BLOCK_CAPACITY], non-NULL only for TEXT columns.
  *   str_lens[i] == strlen(data.str[i]) when data.str[i] != NULL.
- *   NULL means lengths are unknown — callers must fall back to strlen. */
+ *   NULL means lengths are unknown — callers must fall back to strlen.
+ * dict/dict_codes: set by table scans of a dictionary-encoded TEXT column;
+ *   dict_codes[i] is the code of data.str[i] (which is dict->strs[code]).
+ *   Like str_lens they describe the rows as scanned — consumers check
+ *   dict->strs[code] == data.str[i] before trusting a code.
+ * str_pfx: str_pfx(data.str[i]) for each non-NULL row (see "TEXT prefixes"),
+ *   borrowed from the scanned flat_table like str_lens, or NULL. */
 struct col_block {
     enum column_type type;
     uint16_t         count;                    /* 0..BLOCK_CAPACITY */
@@ -26,6 +80,9 @@ struct col_block {
     uint32_t        *str_lens;                 /* TEXT only: bump-alloc'd lengths, or NULL */
     const void      *ext_data;                 /* borrowed mode: points into flat_table col_data */
     const uint8_t   *ext_nulls;                /* borrowed mode: points into flat_table col_nulls */
+    const struct flat_dict *dict;              /* TEXT only: scanned column's dictionary, or NULL */
+    const int32_t   *dict_codes;               /* TEXT only: codes parallel to data.str, or NULL */
+    const uint64_t  *str_pfx;                  /* TEXT only: str_pfx() per row, or NULL */
     union {
         int16_t          i16[BLOCK_CAPACITY];         /* SMALLINT */
         int32_t          i32[BLOCK_CAPACITY];         /* INT, BOOLEAN, DATE */
@@ -212,6 +269,9 @@ static inline void row_block_reset(struct row_block *rb)
     for (uint16_t i = 0; i < rb->ncols; i++) {
         rb->cols[i].count = 0;
         rb->cols[i].str_lens = NULL;
+        rb->cols[i].dict = NULL;
+        rb->cols[i].dict_codes = NULL;
+        rb->cols[i].str_pfx = NULL;
         rb->cols[i].borrowed = 0;
         rb->cols[i].ext_data = NULL;
         rb->cols[i].ext_nulls = NULL;
@@ -232,120 +292,229 @@ static inline uint16_t row_block_row_idx(const struct row_block *rb, uint16_t i)
     return rb->sel ? (uint16_t)rb->sel[i] : i;
 }
 
-#define FNV_OFFSET 2166136261u
-#define FNV_PRIME  16777619u
+/* ---- Hash kernels ----
+ * Fixed-width keys go through a 64-bit multiply-xorshift finalizer
+ * (murmur3's fmix64) instead of byte-at-a-time FNV-1a; strings and other
+ * byte ranges are consumed eight bytes per step.  Every integer width
+ * hashes through block_hash_i64, so SMALLINT, INT and BIGINT keys with
+ * equal values land in the same bucket without any widening at call sites.
+ * Hashes are truncated to 32 bits, which is all the hash tables use. */
 
-/* FNV-1a hash for int32 */
-static inline uint32_t block_hash_i32(int32_t v)
+#define BLOCK_HASH_SEED 0x811c9dc5u  /* starting value for multi-column row hashes */
+#define BLOCK_HASH_NULL 0x9e3779b9u  /* hash of a NULL cell */
+
+static inline uint64_t block_hash_mix64(uint64_t x)
 {
-    uint32_t h = FNV_OFFSET;
-    uint8_t *p = (uint8_t *)&v;
-    for (int i = 0; i < (int)sizeof(int32_t); i++) {
-        h ^= p[i];
-        h *= FNV_PRIME;
-    }
-    return h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
 }
 
-/* FNV-1a hash for int64 */
 static inline uint32_t block_hash_i64(int64_t v)
 {
-    uint32_t h = FNV_OFFSET;
-    uint8_t *p = (uint8_t *)&v;
-    for (int i = 0; i < (int)sizeof(int64_t); i++) {
-        h ^= p[i];
-        h *= FNV_PRIME;
-    }
-    return h;
+    return (uint32_t)block_hash_mix64((uint64_t)v);
+}
+
+static inline uint32_t block_hash_i32(int32_t v)
+{
+    return block_hash_i64((int64_t)v);
 }
 
-/* FNV-1a hash for double */
 static inline uint32_t block_hash_f64(double v)
 {
     if (v == 0.0) v = 0.0; /* canonicalize -0.0 → +0.0 */
-    uint32_t h = FNV_OFFSET;
-    uint8_t *p = (uint8_t *)&v;
-    for (int i = 0; i < (int)sizeof(double); i++) {
-        h ^= p[i];
-        h *= FNV_PRIME;
-    }
-    return h;
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return (uint32_t)block_hash_mix64(bits);
 }
 
-/* FNV-1a hash for string (null-terminated, length unknown) */
-static inline uint32_t block_hash_str(const char *s)
+/* Hash n bytes at p, one 64-bit word per step. */
+static inline uint32_t block_hash_bytes(const void *p, size_t n)
 {
-    uint32_t h = FNV_OFFSET;
-    if (!s) return h;
-    while (*s) {
-        h ^= (uint8_t)*s++;
-        h *= FNV_PRIME;
+    const uint8_t *s = (const uint8_t *)p;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ ((uint64_t)n * 0xc2b2ae3d27d4eb4fULL);
+    while (n >= 8) {
+        uint64_t w;
+        memcpy(&w, s, 8);
+        h ^= w * 0x87c37b91114253d5ULL;
+        h = ((h << 27) | (h >> 37)) * 0x4cf5ad432745937fULL;
+        s += 8;
+        n -= 8;
     }
-    return h;
+    if (n) {
+        /* tail of 1..7 bytes: fixed-size (possibly overlapping) loads so
+         * no variable-length memcpy is needed; the length is already in h */
+        uint64_t w;
+        if (n >= 4) {
+            uint32_t lo, hi;
+            memcpy(&lo, s, 4);
+            memcpy(&hi, s + n - 4, 4);
+            w = (uint64_t)lo | ((uint64_t)hi << 32);
+        } else {
+            w = (uint64_t)s[0] | ((uint64_t)s[n >> 1] << 8) | ((uint64_t)s[n - 1] << 16);
+        }
+        h ^= w * 0x87c37b91114253d5ULL;
+        h = ((h << 27) | (h >> 37)) * 0x4cf5ad432745937fULL;
+    }
+    return (uint32_t)block_hash_mix64(h);
 }
 
-/* FNV-1a hash for string with known length — avoids null scan */
+/* Hash for string with known length — avoids null scan */
 static inline uint32_t block_hash_str_n(const char *s, uint32_t len)
 {
-    uint32_t h = FNV_OFFSET;
-    if (!s) return h;
-    for (uint32_t i = 0; i < len; i++) {
-        h ^= (uint8_t)s[i];
-        h *= FNV_PRIME;
-    }
-    return h;
+    if (!s) return BLOCK_HASH_NULL;
+    return block_hash_bytes(s, len);
 }
 
-/* Hash a col_block value at index i */
-static inline uint32_t block_hash_cell(const struct col_block *cb, uint16_t i)
+/* Hash for string (null-terminated, length unknown) */
+static inline uint32_t block_hash_str(const char *s)
+{
+    if (!s) return BLOCK_HASH_NULL;
+    return block_hash_bytes(s, strlen(s));
+}
+
+/* Fold one column's hash into a multi-column row hash. */
+static inline uint32_t block_hash_combine(uint32_t h, uint32_t v)
+{
+    h = (h ^ v) * 0x9e3779b1u;
+    return h ^ (h >> 15);
+}
+
+/* Hash a non-NULL value of the given type at index i of a typed array.
+ * vec_dim is only consulted for VECTOR. */
+static inline uint32_t block_hash_value(enum column_type type, const void *data,
+                                        size_t i, uint16_t vec_dim)
 {
-    if (cb_nulls(cb)[i]) return 0;
-    switch (cb->type) {
+    switch (type) {
         case COLUMN_TYPE_SMALLINT:
-            return block_hash_i32((int32_t)cb_i16(cb)[i]);
+            return block_hash_i64(((const int16_t *)data)[i]);
         case COLUMN_TYPE_INT:
         case COLUMN_TYPE_BOOLEAN:
         case COLUMN_TYPE_DATE:
-            return block_hash_i32(cb_i32(cb)[i]);
+        case COLUMN_TYPE_ENUM:
+            return block_hash_i64(((const int32_t *)data)[i]);
         case COLUMN_TYPE_BIGINT:
         case COLUMN_TYPE_TIMESTAMP:
         case COLUMN_TYPE_TIMESTAMPTZ:
         case COLUMN_TYPE_TIME:
-            return block_hash_i64(cb_i64(cb)[i]);
+            return block_hash_i64(((const int64_t *)data)[i]);
         case COLUMN_TYPE_FLOAT:
         case COLUMN_TYPE_NUMERIC:
-            return block_hash_f64(cb_f64(cb)[i]);
+            return block_hash_f64(((const double *)data)[i]);
         case COLUMN_TYPE_TEXT:
-            if (cb->str_lens)
-                return block_hash_str_n(cb_str(cb)[i], cb->str_lens[i]);
-            return block_hash_str(cb_str(cb)[i]);
-        case COLUMN_TYPE_ENUM:
-            return block_hash_i32(cb_i32(cb)[i]);
+            return block_hash_str(((const char *const *)data)[i]);
         case COLUMN_TYPE_UUID: {
-            uint64_t uh = uuid_hash(cb_uuid(cb)[i]);
+            uint64_t uh = uuid_hash(((const struct uuid_val *)data)[i]);
             return (uint32_t)(uh ^ (uh >> 32));
         }
-        case COLUMN_TYPE_INTERVAL: {
-            struct interval iv_val = cb_iv(cb)[i];
-            uint32_t h = FNV_OFFSET;
-            uint8_t *p = (uint8_t *)&iv_val;
-            for (int j = 0; j < (int)sizeof(struct interval); j++) {
-                h ^= p[j]; h *= FNV_PRIME;
-            }
-            return h;
+        case COLUMN_TYPE_INTERVAL:
+            return block_hash_bytes(&((const struct interval *)data)[i],
+                                    sizeof(struct interval));
+        case COLUMN_TYPE_VECTOR:
+            return block_hash_bytes(&((const float *)data)[i * vec_dim],
+                                    vec_dim * sizeof(float));
+    }
+    __builtin_unreachable();
+}
+
+/* Hash a col_block value at index i */
+static inline uint32_t block_hash_cell(const struct col_block *cb, uint16_t i)
+{
+    if (cb_nulls(cb)[i]) return BLOCK_HASH_NULL;
+    if (cb->type == COLUMN_TYPE_TEXT) {
+        if (cb->dict_codes) {
+            int32_t code = cb->dict_codes[i];
+            if (code >= 0 && cb->dict->strs[code] == cb_str(cb)[i])
+                return cb->dict->hashes[code];
         }
-        case COLUMN_TYPE_VECTOR: {
-            uint32_t h = FNV_OFFSET;
-            const uint8_t *p = (const uint8_t *)&cb_vec(cb)[i * cb->vec_dim];
-            for (int j = 0; j < (int)(cb->vec_dim * sizeof(float)); j++) {
-                h ^= p[j]; h *= FNV_PRIME;
-            }
-            return h;
+        if (cb->str_lens)
+            return block_hash_str_n(cb_str(cb)[i], cb->str_lens[i]);
+    }
+    return block_hash_value(cb->type, cb_data_ptr(cb, 0), i, cb->vec_dim);
+}
+
+/* ---- Column-at-a-time hashing ----
+ * Hash rows [0, n) of a whole column with one type dispatch, writing
+ * out[i] for physical row i (callers with a selection vector index out[]
+ * by row_block_row_idx).  Results match block_hash_cell row for row, so a
+ * table built one way can be probed the other. */
+static inline void block_hash_column(const struct col_block *cb, uint16_t n, uint32_t *out)
+{
+    const uint8_t *nulls = cb_nulls(cb);
+    switch (column_type_storage(cb->type)) {
+    case STORE_I16: {
+        const int16_t *d = cb_i16(cb);
+        for (uint16_t i = 0; i < n; i++) {
+            uint32_t h = block_hash_i64(d[i]);
+            out[i] = nulls[i] ? BLOCK_HASH_NULL : h;
+        }
+        return;
+    }
+    case STORE_I32: {
+        const int32_t *d = cb_i32(cb);
+        for (uint16_t i = 0; i < n; i++) {
+            uint32_t h = block_hash_i64(d[i]);
+            out[i] = nulls[i] ? BLOCK_HASH_NULL : h;
+        }
+        return;
+    }
+    case STORE_I64: {
+        const int64_t *d = cb_i64(cb);
+        for (uint16_t i = 0; i < n; i++) {
+            uint32_t h = block_hash_i64(d[i]);
+            out[i] = nulls[i] ? BLOCK_HASH_NULL : h;
+        }
+        return;
+    }
+    case STORE_F64: {
+        const double *d = cb_f64(cb);
+        for (uint16_t i = 0; i < n; i++) {
+            uint32_t h = block_hash_f64(d[i]);
+            out[i] = nulls[i] ? BLOCK_HASH_NULL : h;
+        }
+        return;
+    }
+    case STORE_STR: {
+        char *const *d = cb_str(cb);
+        const int32_t *codes = cb->dict_codes;
+        const uint32_t *lens = cb->str_lens;
+        for (uint16_t i = 0; i < n; i++) {
+            if (nulls[i]) { out[i] = BLOCK_HASH_NULL; continue; }
+            if (codes && codes[i] >= 0 && cb->dict->strs[codes[i]] == d[i])
+                out[i] = cb->dict->hashes[codes[i]];
+            else
+                out[i] = lens ? block_hash_str_n(d[i], lens[i]) : block_hash_str(d[i]);
         }
+        return;
+    }
+    case STORE_IV:
+    case STORE_UUID:
+    case STORE_VEC:
+        for (uint16_t i = 0; i < n; i++)
+            out[i] = block_hash_cell(cb, i);
+        return;
     }
     __builtin_unreachable();
 }
 
+/* Multi-column key hash for rows [0, n): seed, then fold in one key
+ * column at a time.  Agrees with flat_table_hash_row on the same values. */
+static inline void block_hash_key(const struct col_block *const *keys, uint16_t nkeys,
+                                  uint16_t n, uint32_t *out)
+{
+    uint32_t ch[BLOCK_CAPACITY];
+    for (uint16_t i = 0; i < n; i++)
+        out[i] = BLOCK_HASH_SEED;
+    for (uint16_t k = 0; k < nkeys; k++) {
+        block_hash_column(keys[k], n, ch);
+        for (uint16_t i = 0; i < n; i++)
+            out[i] = block_hash_combine(out[i], ch[i]);
+    }
+}
+
 /* Compare two col_block values: returns 1 if equal, 0 if not */
 static inline int block_cell_eq(const struct col_block *a, uint16_t ai,
                                 const struct col_block *b, uint16_t bi)
@@ -368,7 +537,12 @@ static inline int block_cell_eq(const struct col_block *a, uint16_t ai,
             return cb_f64(a)[ai] == cb_f64(b)[bi];
         case COLUMN_TYPE_TEXT: {
             const char *sa = cb_str(a)[ai], *sb = cb_str(b)[bi];
-            if (!sa || !sb) return sa == sb;
+            if (!sa || !sb || sa == sb) return sa == sb;
+            if (a->str_pfx && b->str_pfx) {
+                uint64_t pa = a->str_pfx[ai];
+                if (pa != b->str_pfx[bi]) return 0;
+                if (!(pa & 0xff)) return 1;
+            }
             if (a->str_lens && b->str_lens) {
                 if (a->str_lens[ai] != b->str_lens[bi]) return 0;
                 return memcmp(sa, sb, a->str_lens[ai]) == 0;
@@ -392,6 +566,98 @@ static inline int block_cell_eq(const struct col_block *a, uint16_t ai,
     __builtin_unreachable();
 }
 
+/* ---- String heap: chunked, append-only storage for flat_table TEXT ----
+ *
+ * Values are copied into FLAT_STRHEAP_CHUNK-sized chunks (or a chunk of
+ * their own when large) and never freed one by one: overwritten and
+ * deleted values are only counted as garbage, and the whole heap goes
+ * away at once in flat_table_free.  table_flat_compact_strings (table.c)
+ * copies the live values into a fresh heap once garbage outweighs them. */
+#define FLAT_STRHEAP_CHUNK (64 * 1024)
+
+struct flat_strheap_chunk {
+    struct flat_strheap_chunk *next;
+    size_t                     used;
+    size_t                     cap;
+    char                       data[];
+};
+
+struct flat_strheap {
+    struct flat_strheap_chunk *head;   /* chunk being filled; older chunks follow */
+    size_t                     live;   /* bytes (incl. NUL) of values in use */
+    size_t                     garbage; /* bytes of values overwritten or deleted */
+};
+
+static inline struct flat_strheap *flat_strheap_new(void)
+{
+    struct flat_strheap *h = (struct flat_strheap *)calloc(1, sizeof(*h));
+    if (!h) { fprintf(stderr, "OOM: flat_strheap_new\n"); abort(); }
+    return h;
+}
+
+static inline void flat_strheap_free(struct flat_strheap *h)
+{
+    if (!h) return;
+    struct flat_strheap_chunk *ch = h->head;
+    while (ch) {
+        struct flat_strheap_chunk *next = ch->next;
+        free(ch);
+        ch = next;
+    }
+    free(h);
+}
+
+/* n bytes of heap storage.  Requests of a quarter chunk or more get a chunk
+ * of their own, linked behind the one being filled. */
+static inline char *flat_strheap_alloc(struct flat_strheap *h, size_t n)
+{
+    struct flat_strheap_chunk *ch = h->head;
+    if (ch && ch->cap - ch->used >= n) {
+        char *p = ch->data + ch->used;
+        ch->used += n;
+        return p;
+    }
+    int own = n >= FLAT_STRHEAP_CHUNK / 4;
+    size_t cap = own ? n : FLAT_STRHEAP_CHUNK;
+    struct flat_strheap_chunk *nc =
+        (struct flat_strheap_chunk *)malloc(sizeof(*nc) + cap);
+    if (!nc) { fprintf(stderr, "OOM: flat_strheap_alloc\n"); abort(); }
+    nc->cap = cap;
+    nc->used = n;
+    if (own && ch) {
+        nc->next = ch->next;
+        ch->next = nc;
+    } else {
+        nc->next = ch;
+        h->head = nc;
+    }
+    return nc->data;
+}
+
+/* Copy of the len-byte string s (NUL added), counted as live. */
+static inline char *flat_strheap_dup(struct flat_strheap *h, const char *s, size_t len)
+{
+    char *p = flat_strheap_alloc(h, len + 1);
+    memcpy(p, s, len);
+    p[len] = '\0';
+    h->live += len + 1;
+    return p;
+}
+
+/* A value stored in h is no longer referenced. */
+static inline void flat_strheap_release(struct flat_strheap *h, const char *s)
+{
+    size_t n = strlen(s) + 1;
+    h->live -= n;
+    h->garbage += n;
+}
+
+/* Worth copying the live values into a fresh heap? */
+static inline int flat_strheap_wants_compact(const struct flat_strheap *h)
+{
+    return h && h->garbage >= 16 * FLAT_STRHEAP_CHUNK && h->garbage > h->live;
+}
+
 /* ---- Flat table: heap-allocated columnar storage for N rows, M columns ----
  *
  * Used as the unified representation for:
@@ -403,7 +669,14 @@ static inline int block_cell_eq(const struct col_block *a, uint16_t ai,
  * Ownership: the module that calls flat_table_init() owns the arrays and must
  * call flat_table_free() when done. Cross-module ownership is not permitted.
  *
- * str_lens[c] is non-NULL only for TEXT columns; stores strlen of each entry. */
+ * str_lens[c] is non-NULL only for TEXT columns; stores strlen of each entry.
+ * col_zones is non-NULL only for table.flat (see "Zone maps" below).
+ * col_dicts likewise (see "Dictionary-encoded TEXT" below).
+ * col_str_pfx[c] holds str_pfx() of each TEXT entry where maintained
+ * (table.flat, disk table caches, join caches), else NULL.
+ * str_heap, when non-NULL, holds every TEXT value not in a dictionary
+ * (table.flat and disk table caches); otherwise each value is strdup'd. */
+struct flat_zone;
 struct flat_table {
     uint16_t          ncols;
     size_t            nrows;    /* number of valid rows */
@@ -413,6 +686,10 @@ struct flat_table {
     enum column_type *col_types;     /* [ncols] */
     uint32_t        **col_str_lens;  /* [ncols] non-NULL only for TEXT cols */
     uint16_t         *col_vec_dims;  /* [ncols] VECTOR dims (0 for non-vector cols) */
+    struct flat_zone **col_zones;    /* [ncols] per-block synopses, or NULL */
+    struct flat_dict **col_dicts;    /* [ncols] TEXT dictionaries, or NULL */
+    struct flat_strheap *str_heap;   /* TEXT value storage, or NULL */
+    uint64_t        **col_str_pfx;   /* [ncols] TEXT prefixes, or NULL */
 };
 
 /* Allocate the per-column pointer arrays for a flat_table.
@@ -428,38 +705,88 @@ static inline void flat_table_init(struct flat_table *ft, uint16_t ncols, size_t
     ft->col_types     = (enum column_type *)calloc(ncols, sizeof(enum column_type));
     ft->col_str_lens  = (uint32_t **)calloc(ncols, sizeof(uint32_t *));
     ft->col_vec_dims  = (uint16_t *)calloc(ncols, sizeof(uint16_t));
+    ft->col_zones     = NULL;
+    ft->col_dicts     = NULL;
+    ft->str_heap      = NULL;
+    ft->col_str_pfx   = NULL;
     if (!ft->col_data || !ft->col_nulls || !ft->col_types || !ft->col_str_lens || !ft->col_vec_dims) {
         fprintf(stderr, "OOM: flat_table_init\n"); abort();
     }
 }
 
+/* ---- Flat column memory ----
+ *
+ * The per-row arrays of a flat_table (col_data, col_nulls, col_str_lens,
+ * col_str_pfx) come from flat_mem_alloc and are grown and freed only
+ * through flat_mem_grow / flat_mem_free, with byte sizes derived from
+ * ft->cap (at least one row).  Arrays of FLAT_MEM_MAP_MIN bytes or more
+ * are anonymous memory maps: growing one remaps its pages instead of
+ * copying the rows, so appending to a large table never copies it or
+ * holds two copies at once, and capacity not yet written costs no memory.
+ * Smaller arrays, and everything under MSKQL_WASM, use calloc/realloc.
+ * All three abort on OOM; memory is always zero-filled. */
+#define FLAT_MEM_MAP_MIN ((size_t)256 * 1024)
+
+void *flat_mem_alloc(size_t nbytes);
+/* p holds old_bytes; returns it resized to new_bytes >= old_bytes. */
+void *flat_mem_grow(void *p, size_t old_bytes, size_t new_bytes);
+void  flat_mem_free(void *p, size_t nbytes);
+
+/* Bytes per row of col_data[c]. */
+static inline size_t flat_table_row_size(const struct flat_table *ft, uint16_t c)
+{
+    size_t esz = col_type_elem_size(ft->col_types[c]);
+    return ft->col_types[c] == COLUMN_TYPE_VECTOR ? esz * ft->col_vec_dims[c] : esz;
+}
+
 /* Allocate typed data arrays after col_types[] have been set.
  * Must be called exactly once after flat_table_init + setting col_types. */
 static inline void flat_table_alloc_cols(struct flat_table *ft)
 {
+    size_t cap = ft->cap ? ft->cap : 1;
     for (uint16_t c = 0; c < ft->ncols; c++) {
-        size_t esz = col_type_elem_size(ft->col_types[c]);
-        size_t mul = (ft->col_types[c] == COLUMN_TYPE_VECTOR) ? ft->col_vec_dims[c] : 1;
-        ft->col_data[c]  = calloc(ft->cap ? ft->cap : 1, esz * mul);
-        ft->col_nulls[c] = (uint8_t *)calloc(ft->cap ? ft->cap : 1, 1);
-        if (!ft->col_data[c] || !ft->col_nulls[c]) { fprintf(stderr, "OOM: flat_table_alloc_cols\n"); abort(); }
+        ft->col_data[c]  = flat_mem_alloc(cap * flat_table_row_size(ft, c));
+        ft->col_nulls[c] = (uint8_t *)flat_mem_alloc(cap);
     }
 }
 
+static inline void flat_dict_free(struct flat_dict *d)
+{
+    if (!d) return;
+    for (uint32_t i = 0; i < d->count; i++)
+        free(d->strs[i]);
+    free(d->strs);
+    free(d->lens);
+    free(d->hashes);
+    free(d->slots);
+    free(d->codes);
+    free(d);
+}
+
 /* Free all heap arrays owned by ft. Does not free ft itself. */
 static inline void flat_table_free(struct flat_table *ft)
 {
     if (!ft->col_data) return;
+    size_t cap = ft->cap ? ft->cap : 1;
     for (uint16_t c = 0; c < ft->ncols; c++) {
-        if (ft->col_types[c] == COLUMN_TYPE_TEXT && ft->col_data[c]) {
+        if (ft->col_dicts && ft->col_dicts[c]) {
+            /* every row points into the dictionary */
+            flat_dict_free(ft->col_dicts[c]);
+        } else if (ft->col_types[c] == COLUMN_TYPE_TEXT && ft->col_data[c] && !ft->str_heap) {
             const char **strs = (const char **)ft->col_data[c];
             for (size_t r = 0; r < ft->nrows; r++)
                 free((char *)strs[r]);
         }
-        free(ft->col_data[c]);
-        free(ft->col_nulls[c]);
-        if (ft->col_str_lens) free(ft->col_str_lens[c]);
+        flat_mem_free(ft->col_data[c], cap * flat_table_row_size(ft, c));
+        flat_mem_free(ft->col_nulls[c], cap);
+        if (ft->col_str_lens) flat_mem_free(ft->col_str_lens[c], cap * sizeof(uint32_t));
+        if (ft->col_zones) free(ft->col_zones[c]);
+        if (ft->col_str_pfx) flat_mem_free(ft->col_str_pfx[c], cap * sizeof(uint64_t));
     }
+    free(ft->col_zones);
+    free(ft->col_str_pfx);
+    free(ft->col_dicts);
+    flat_strheap_free(ft->str_heap);
     free(ft->col_data);
     free(ft->col_nulls);
     free(ft->col_types);
@@ -470,85 +797,340 @@ static inline void flat_table_free(struct flat_table *ft)
     ft->col_types = NULL;
     ft->col_str_lens = NULL;
     ft->col_vec_dims = NULL;
+    ft->col_zones = NULL;
+    ft->col_dicts = NULL;
+    ft->str_heap = NULL;
+    ft->col_str_pfx = NULL;
     ft->ncols = 0;
     ft->nrows = 0;
     ft->cap   = 0;
 }
 
 
-/* Grow all column arrays to new_cap. Caller must ensure new_cap > ft->cap.
- * Existing data is preserved; new slots are zero-initialized. */
-static inline void flat_table_grow(struct flat_table *ft, size_t new_cap)
+/* Replace the TEXT value at (c, r) with a copy of s (len bytes), or clear
+ * it when s is NULL, releasing the previous value.  For columns without a
+ * dictionary; table.c's mutators handle dictionary-encoded ones. */
+static inline const char *flat_table_set_text(struct flat_table *ft, uint16_t c, size_t r,
+                                              const char *s, size_t len)
 {
-    for (uint16_t c = 0; c < ft->ncols; c++) {
-        size_t esz = col_type_elem_size(ft->col_types[c]);
-        size_t mul = (ft->col_types[c] == COLUMN_TYPE_VECTOR) ? ft->col_vec_dims[c] : 1;
-        size_t row_sz = esz * mul;
-        void *nd = realloc(ft->col_data[c], new_cap * row_sz);
-        if (!nd) { fprintf(stderr, "OOM: flat_table_grow\n"); abort(); }
-        memset((char *)nd + ft->cap * row_sz, 0, (new_cap - ft->cap) * row_sz);
-        ft->col_data[c] = nd;
-        uint8_t *nn = (uint8_t *)realloc(ft->col_nulls[c], new_cap);
-        if (!nn) { fprintf(stderr, "OOM: flat_table_grow\n"); abort(); }
-        memset(nn + ft->cap, 0, new_cap - ft->cap);
-        ft->col_nulls[c] = nn;
-        if (ft->col_str_lens && ft->col_str_lens[c]) {
-            uint32_t *nl = (uint32_t *)realloc(ft->col_str_lens[c], new_cap * sizeof(uint32_t));
-            if (!nl) { fprintf(stderr, "OOM: flat_table_grow\n"); abort(); }
-            memset(nl + ft->cap, 0, (new_cap - ft->cap) * sizeof(uint32_t));
-            ft->col_str_lens[c] = nl;
-        }
+    const char **strs = (const char **)ft->col_data[c];
+    if (s == strs[r]) return s;   /* row rebuilt from its own cells */
+    if (ft->col_str_pfx && ft->col_str_pfx[c])
+        ft->col_str_pfx[c][r] = s ? str_pfx_n(s, len) : 0;
+    if (ft->str_heap) {
+        if (strs[r]) flat_strheap_release(ft->str_heap, strs[r]);
+        strs[r] = s ? flat_strheap_dup(ft->str_heap, s, len) : NULL;
+        return strs[r];
     }
-    ft->cap = new_cap;
+    free((char *)strs[r]);
+    char *dup = NULL;
+    if (s) {
+        dup = (char *)malloc(len + 1);
+        if (!dup) { fprintf(stderr, "OOM: flat_table_set_text\n"); abort(); }
+        memcpy(dup, s, len);
+        dup[len] = '\0';
+    }
+    strs[r] = dup;
+    return dup;
 }
 
-/* Hash a single value in flat_table column c at row r. */
-static inline uint32_t flat_table_hash_cell(const struct flat_table *ft, uint16_t c, size_t r)
+
+/* ---- Zone maps: per-block synopses of a flat_table column ----
+ *
+ * Zone z of column c summarizes rows [z * FLAT_ZONE_ROWS, (z + 1) * FLAT_ZONE_ROWS)
+ * so scans can skip whole blocks a predicate cannot match.  Integer-class
+ * columns (SMALLINT, INT, BOOLEAN, DATE, ENUM, BIGINT, TIME, TIMESTAMP[TZ])
+ * keep min/max in .i, FLOAT/NUMERIC in .f; other types keep counts only.
+ *
+ * Counts are exact.  min/max cover every non-NULL value in the zone but may
+ * be wider: UPDATE and DELETE only ever widen them.  A zone with nvals == 0
+ * has no non-NULL rows and its min/max are meaningless.
+ *
+ * Only table.flat carries zones (table_flat_init_schema enables them, the
+ * table_flat_* mutators maintain them); everything else leaves col_zones NULL. */
+#define FLAT_ZONE_ROWS BLOCK_CAPACITY
+
+union flat_zone_val {
+    int64_t i;
+    double  f;
+};
+
+struct flat_zone {
+    union flat_zone_val min, max;
+    uint32_t            nnulls;   /* NULL rows in the zone */
+    uint32_t            nvals;    /* non-NULL rows in the zone */
+};
+
+enum flat_zone_kind {
+    FLAT_ZONE_COUNTS,   /* null / non-null counts only */
+    FLAT_ZONE_INT,
+    FLAT_ZONE_FLOAT
+};
+
+static inline enum flat_zone_kind flat_zone_kind_of(enum column_type ct)
 {
-    if (ft->col_nulls[c][r]) return 0;
-    switch (ft->col_types[c]) {
+    switch (ct) {
     case COLUMN_TYPE_SMALLINT:
-        return block_hash_i32((int32_t)((int16_t *)ft->col_data[c])[r]);
     case COLUMN_TYPE_INT:
     case COLUMN_TYPE_BOOLEAN:
     case COLUMN_TYPE_DATE:
     case COLUMN_TYPE_ENUM:
-        return block_hash_i32(((int32_t *)ft->col_data[c])[r]);
     case COLUMN_TYPE_BIGINT:
+    case COLUMN_TYPE_TIME:
     case COLUMN_TYPE_TIMESTAMP:
     case COLUMN_TYPE_TIMESTAMPTZ:
+        return FLAT_ZONE_INT;
+    case COLUMN_TYPE_FLOAT:
+    case COLUMN_TYPE_NUMERIC:
+        return FLAT_ZONE_FLOAT;
+    case COLUMN_TYPE_TEXT:
+    case COLUMN_TYPE_INTERVAL:
+    case COLUMN_TYPE_UUID:
+    case COLUMN_TYPE_VECTOR:
+        return FLAT_ZONE_COUNTS;
+    }
+    __builtin_unreachable();
+}
+
+static inline size_t flat_zone_count(size_t nrows)
+{
+    return (nrows + FLAT_ZONE_ROWS - 1) / FLAT_ZONE_ROWS;
+}
+
+/* Integer-class value of (c, r) widened to int64. */
+static inline int64_t flat_zone_int_at(const struct flat_table *ft, uint16_t c, size_t r)
+{
+    switch (ft->col_types[c]) {
+    case COLUMN_TYPE_SMALLINT: return ((const int16_t *)ft->col_data[c])[r];
+    case COLUMN_TYPE_BIGINT:
     case COLUMN_TYPE_TIME:
-        return block_hash_i64(((int64_t *)ft->col_data[c])[r]);
+    case COLUMN_TYPE_TIMESTAMP:
+    case COLUMN_TYPE_TIMESTAMPTZ: return ((const int64_t *)ft->col_data[c])[r];
+    case COLUMN_TYPE_INT:
+    case COLUMN_TYPE_BOOLEAN:
+    case COLUMN_TYPE_DATE:
+    case COLUMN_TYPE_ENUM:
     case COLUMN_TYPE_FLOAT:
     case COLUMN_TYPE_NUMERIC:
-        return block_hash_f64(((double *)ft->col_data[c])[r]);
-    case COLUMN_TYPE_TEXT: {
-        const char *s = ((const char **)ft->col_data[c])[r];
-        if (ft->col_str_lens && ft->col_str_lens[c])
-            return block_hash_str_n(s, ft->col_str_lens[c][r]);
-        return block_hash_str(s);
+    case COLUMN_TYPE_TEXT:
+    case COLUMN_TYPE_INTERVAL:
+    case COLUMN_TYPE_UUID:
+    case COLUMN_TYPE_VECTOR:
+        break;
     }
-    case COLUMN_TYPE_UUID: {
-        struct uuid_val u = ((struct uuid_val *)ft->col_data[c])[r];
-        uint64_t uh = uuid_hash(u);
-        return (uint32_t)(uh ^ (uh >> 32));
+    return ((const int32_t *)ft->col_data[c])[r];
+}
+
+/* Fold row r of column c into zone z. */
+static inline void flat_zone_add(struct flat_zone *z, const struct flat_table *ft,
+                                 uint16_t c, size_t r)
+{
+    if (ft->col_nulls[c][r]) { z->nnulls++; return; }
+    switch (flat_zone_kind_of(ft->col_types[c])) {
+    case FLAT_ZONE_INT: {
+        int64_t v = flat_zone_int_at(ft, c, r);
+        if (z->nvals == 0 || v < z->min.i) z->min.i = v;
+        if (z->nvals == 0 || v > z->max.i) z->max.i = v;
+        break;
     }
-    case COLUMN_TYPE_INTERVAL: {
-        struct interval iv = ((struct interval *)ft->col_data[c])[r];
-        uint32_t h = FNV_OFFSET;
-        uint8_t *p = (uint8_t *)&iv;
-        for (int j = 0; j < (int)sizeof(struct interval); j++) { h ^= p[j]; h *= FNV_PRIME; }
-        return h;
+    case FLAT_ZONE_FLOAT: {
+        double v = ((const double *)ft->col_data[c])[r];
+        if (v != v) {
+            /* NaN orders after everything in SQL: stop bounding the zone */
+            z->min.f = -__builtin_inf();
+            z->max.f = __builtin_inf();
+            break;
+        }
+        if (z->nvals == 0 || v < z->min.f) z->min.f = v;
+        if (z->nvals == 0 || v > z->max.f) z->max.f = v;
+        break;
     }
-    case COLUMN_TYPE_VECTOR: {
-        uint16_t dim = ft->col_vec_dims[c];
-        uint32_t h = FNV_OFFSET;
-        uint8_t *p = (uint8_t *)&((float *)ft->col_data[c])[r * dim];
-        for (int j = 0; j < (int)(dim * sizeof(float)); j++) { h ^= p[j]; h *= FNV_PRIME; }
-        return h;
+    case FLAT_ZONE_COUNTS:
+        break;
     }
+    z->nvals++;
+}
+
+/* Take row r of column c out of zone z's counts (min/max stay as they are). */
+static inline void flat_zone_remove(struct flat_zone *z, const struct flat_table *ft,
+                                    uint16_t c, size_t r)
+{
+    if (ft->col_nulls[c][r]) z->nnulls--;
+    else z->nvals--;
+}
+
+/* Allocate zeroed zones covering ft->cap rows for every column. */
+static inline void flat_table_enable_zones(struct flat_table *ft)
+{
+    size_t nz = flat_zone_count(ft->cap ? ft->cap : 1);
+    ft->col_zones = (struct flat_zone **)calloc(ft->ncols, sizeof(struct flat_zone *));
+    if (!ft->col_zones) { fprintf(stderr, "OOM: flat_table_enable_zones\n"); abort(); }
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        ft->col_zones[c] = (struct flat_zone *)calloc(nz, sizeof(struct flat_zone));
+        if (!ft->col_zones[c]) { fprintf(stderr, "OOM: flat_table_enable_zones\n"); abort(); }
     }
-    __builtin_unreachable();
+}
+
+/* ---- Dictionary-encoded TEXT ----
+ *
+ * A TEXT column of table.flat starts out dictionary-encoded: each distinct
+ * value is stored once in a flat_dict, col_data[c][r] points at that copy
+ * and codes[r] holds its index.  col_data keeps its char * layout so every
+ * reader works unchanged; operators that know about dictionaries (filters,
+ * block_hash_cell) work on the codes instead and evaluate a predicate or a
+ * hash once per distinct value.
+ *
+ * Codes are stable for the life of the dictionary: values are only ever
+ * appended, so one left unreferenced by UPDATE or DELETE stays until the
+ * table is rebuilt.  Interning a value past FLAT_DICT_MAX fails, and the
+ * table_flat_* mutators then fall back to one strdup per row for that
+ * column (col_dicts[c] = NULL) for good.
+ *
+ * Only table.flat has dictionaries (table_flat_init_schema enables them);
+ * everything else leaves col_dicts NULL. */
+#define FLAT_DICT_MAX 4096
+
+static inline struct flat_dict *flat_dict_new(size_t row_cap)
+{
+    struct flat_dict *d = (struct flat_dict *)calloc(1, sizeof(*d));
+    if (!d) { fprintf(stderr, "OOM: flat_dict_new\n"); abort(); }
+    d->codes = (int32_t *)malloc((row_cap ? row_cap : 1) * sizeof(int32_t));
+    if (!d->codes) { fprintf(stderr, "OOM: flat_dict_new\n"); abort(); }
+    memset(d->codes, 0xff, (row_cap ? row_cap : 1) * sizeof(int32_t));
+    return d;
+}
+
+/* Code of s in d, or -1. */
+static inline int32_t flat_dict_find(const struct flat_dict *d, const char *s,
+                                     uint32_t len, uint32_t h)
+{
+    if (!d->nslots) return -1;
+    uint32_t mask = d->nslots - 1;
+    for (uint32_t i = h & mask; d->slots[i]; i = (i + 1) & mask) {
+        uint32_t code = d->slots[i] - 1;
+        if (d->hashes[code] == h && d->lens[code] == len &&
+            memcmp(d->strs[code], s, len) == 0)
+            return (int32_t)code;
+    }
+    return -1;
+}
+
+/* Code of s in d, adding a copy of s if it is new.  Returns -1 when d
+ * already holds FLAT_DICT_MAX values and s is not one of them. */
+static inline int32_t flat_dict_intern(struct flat_dict *d, const char *s)
+{
+    uint32_t len = (uint32_t)strlen(s);
+    uint32_t h = block_hash_str_n(s, len);
+    int32_t code = flat_dict_find(d, s, len, h);
+    if (code >= 0) return code;
+    if (d->count >= FLAT_DICT_MAX) return -1;
+    if (d->count == d->cap) {
+        uint32_t ncap = d->cap ? d->cap * 2 : 16;
+        char **ns = (char **)realloc(d->strs, ncap * sizeof(char *));
+        if (!ns) { fprintf(stderr, "OOM: flat_dict_intern\n"); abort(); }
+        d->strs = ns;
+        uint32_t *nl = (uint32_t *)realloc(d->lens, ncap * sizeof(uint32_t));
+        if (!nl) { fprintf(stderr, "OOM: flat_dict_intern\n"); abort(); }
+        d->lens = nl;
+        uint32_t *nh = (uint32_t *)realloc(d->hashes, ncap * sizeof(uint32_t));
+        if (!nh) { fprintf(stderr, "OOM: flat_dict_intern\n"); abort(); }
+        d->hashes = nh;
+        d->cap = ncap;
+        /* rehash into 2x the entry capacity */
+        free(d->slots);
+        d->nslots = ncap * 2;
+        d->slots = (uint32_t *)calloc(d->nslots, sizeof(uint32_t));
+        if (!d->slots) { fprintf(stderr, "OOM: flat_dict_intern\n"); abort(); }
+        for (uint32_t i = 0; i < d->count; i++) {
+            uint32_t j = d->hashes[i] & (d->nslots - 1);
+            while (d->slots[j]) j = (j + 1) & (d->nslots - 1);
+            d->slots[j] = i + 1;
+        }
+    }
+    char *copy = (char *)malloc(len + 1);
+    if (!copy) { fprintf(stderr, "OOM: flat_dict_intern\n"); abort(); }
+    memcpy(copy, s, len + 1);
+    code = (int32_t)d->count++;
+    d->strs[code] = copy;
+    d->lens[code] = len;
+    d->hashes[code] = h;
+    uint32_t j = h & (d->nslots - 1);
+    while (d->slots[j]) j = (j + 1) & (d->nslots - 1);
+    d->slots[j] = (uint32_t)code + 1;
+    return code;
+}
+
+/* Give every TEXT column an empty dictionary (ft must have no rows yet). */
+static inline void flat_table_enable_dicts(struct flat_table *ft)
+{
+    ft->col_dicts = (struct flat_dict **)calloc(ft->ncols, sizeof(struct flat_dict *));
+    if (!ft->col_dicts) { fprintf(stderr, "OOM: flat_table_enable_dicts\n"); abort(); }
+    for (uint16_t c = 0; c < ft->ncols; c++)
+        if (ft->col_types[c] == COLUMN_TYPE_TEXT)
+            ft->col_dicts[c] = flat_dict_new(ft->cap);
+}
+
+/* Keep a prefix array (see "TEXT prefixes") for every TEXT column; entries
+ * of the rows already present are computed here. */
+static inline void flat_table_enable_str_pfx(struct flat_table *ft)
+{
+    ft->col_str_pfx = (uint64_t **)calloc(ft->ncols, sizeof(uint64_t *));
+    if (!ft->col_str_pfx) { fprintf(stderr, "OOM: flat_table_enable_str_pfx\n"); abort(); }
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        if (ft->col_types[c] != COLUMN_TYPE_TEXT) continue;
+        uint64_t *pfx = (uint64_t *)flat_mem_alloc((ft->cap ? ft->cap : 1) * sizeof(uint64_t));
+        const char *const *strs = (const char *const *)ft->col_data[c];
+        for (size_t r = 0; r < ft->nrows; r++)
+            if (!ft->col_nulls[c][r]) pfx[r] = str_pfx(strs[r]);
+        ft->col_str_pfx[c] = pfx;
+    }
+}
+
+/* Grow all column arrays to new_cap. Caller must ensure new_cap > ft->cap.
+ * Existing data is preserved; new slots are zero-initialized.  Arrays past
+ * FLAT_MEM_MAP_MIN are remapped rather than copied (see "Flat column memory"). */
+static inline void flat_table_grow(struct flat_table *ft, size_t new_cap)
+{
+    size_t old_cap = ft->cap ? ft->cap : 1;
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        size_t row_sz = flat_table_row_size(ft, c);
+        ft->col_data[c] = flat_mem_grow(ft->col_data[c], old_cap * row_sz, new_cap * row_sz);
+        ft->col_nulls[c] = (uint8_t *)flat_mem_grow(ft->col_nulls[c], old_cap, new_cap);
+        if (ft->col_str_lens && ft->col_str_lens[c])
+            ft->col_str_lens[c] = (uint32_t *)flat_mem_grow(ft->col_str_lens[c],
+                                      old_cap * sizeof(uint32_t), new_cap * sizeof(uint32_t));
+        if (ft->col_str_pfx && ft->col_str_pfx[c])
+            ft->col_str_pfx[c] = (uint64_t *)flat_mem_grow(ft->col_str_pfx[c],
+                                     old_cap * sizeof(uint64_t), new_cap * sizeof(uint64_t));
+        if (ft->col_zones) {
+            size_t old_nz = flat_zone_count(ft->cap ? ft->cap : 1);
+            size_t new_nz = flat_zone_count(new_cap);
+            if (new_nz > old_nz) {
+                struct flat_zone *nzs = (struct flat_zone *)realloc(ft->col_zones[c],
+                                            new_nz * sizeof(struct flat_zone));
+                if (!nzs) { fprintf(stderr, "OOM: flat_table_grow\n"); abort(); }
+                memset(nzs + old_nz, 0, (new_nz - old_nz) * sizeof(struct flat_zone));
+                ft->col_zones[c] = nzs;
+            }
+        }
+        if (ft->col_dicts && ft->col_dicts[c]) {
+            struct flat_dict *d = ft->col_dicts[c];
+            int32_t *ncodes = (int32_t *)realloc(d->codes, new_cap * sizeof(int32_t));
+            if (!ncodes) { fprintf(stderr, "OOM: flat_table_grow\n"); abort(); }
+            memset(ncodes + ft->cap, 0xff, (new_cap - ft->cap) * sizeof(int32_t));
+            d->codes = ncodes;
+        }
+    }
+    ft->cap = new_cap;
+}
+
+/* Hash a single value in flat_table column c at row r. */
+static inline uint32_t flat_table_hash_cell(const struct flat_table *ft, uint16_t c, size_t r)
+{
+    if (ft->col_nulls[c][r]) return BLOCK_HASH_NULL;
+    if (ft->col_types[c] == COLUMN_TYPE_TEXT && ft->col_str_lens && ft->col_str_lens[c])
+        return block_hash_str_n(((const char **)ft->col_data[c])[r], ft->col_str_lens[c][r]);
+    return block_hash_value(ft->col_types[c], ft->col_data[c], r, ft->col_vec_dims[c]);
 }
 
 /* Compare two cells in the same flat_table column: returns 1 if equal, 0 if not. */
@@ -576,6 +1158,11 @@ static inline int flat_table_eq_cell(const struct flat_table *ft, uint16_t c,
         const char *sa = ((const char **)ft->col_data[c])[ra];
         const char *sb = ((const char **)ft->col_data[c])[rb];
         if (!sa || !sb) return sa == sb;
+        if (ft->col_str_pfx && ft->col_str_pfx[c]) {
+            uint64_t pa = ft->col_str_pfx[c][ra];
+            if (pa != ft->col_str_pfx[c][rb]) return 0;
+            if (!(pa & 0xff)) return 1;
+        }
         if (ft->col_str_lens && ft->col_str_lens[c]) {
             if (ft->col_str_lens[c][ra] != ft->col_str_lens[c][rb]) return 0;
             return memcmp(sa, sb, ft->col_str_lens[c][ra]) == 0;
@@ -605,11 +1192,9 @@ static inline int flat_table_eq_cell(const struct flat_table *ft, uint16_t c,
 /* Hash the first ncols columns of flat_table row r (FNV-1a). */
 static inline uint32_t flat_table_hash_row(const struct flat_table *ft, size_t r, uint16_t ncols)
 {
-    uint32_t h = FNV_OFFSET;
-    for (uint16_t c = 0; c < ncols; c++) {
-        h ^= flat_table_hash_cell(ft, c, r);
-        h *= FNV_PRIME;
-    }
+    uint32_t h = BLOCK_HASH_SEED;
+    for (uint16_t c = 0; c < ncols; c++)
+        h = block_hash_combine(h, flat_table_hash_cell(ft, c, r));
     return h;
 }
 
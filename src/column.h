@@ -149,7 +149,7 @@ enum fk_action {
 
 struct column {
     // TODO: STRINGVIEW OPPORTUNITY: name and enum_type_name are char* requiring strdup/free
-    // on every copy (table_add_column, do_single_join, rebuild_indexes, query_free, etc.).
+    // on every copy (table_add_column, do_single_join, query_free, etc.).
     // These originate from parser tokens which are already sv. Storing them as sv (pointing
     // into the original SQL or a persistent schema buffer) would eliminate many allocations.
     char *name;
@@ -5,6 +5,7 @@
 #include "logical.h"
 #include "explain_ast.h"
 #include "catalog.h"
+#include "spill.h"
 #include "parquet.h"
 #include "stringview.h"
 #include <string.h>
@@ -26,6 +27,7 @@ void db_init(struct database *db, const char *name)
     db->active_txn = NULL;
     db->total_generation = 0;
     db->catalog_path = NULL;
+    db->work_mem = spill_default_work_mem();
 }
 
 struct enum_type *db_find_type(struct database *db, const char *name)
@@ -76,6 +78,14 @@ struct table *db_find_table_sv(struct database *db, sv name)
     return NULL;
 }
 
+/* Undo trigger for a statement about to change rows of t. */
+static void db_txn_note_write(struct database *db, struct table *t)
+{
+    struct txn_state *txn = db->active_txn;
+    if (txn && txn->in_transaction && txn->snapshot)
+        snapshot_log_table(txn->snapshot, db, t);
+}
+
 int db_table_exec_query(struct database *db, sv table_name,
                         struct query *q, struct rows *result, struct bump_alloc *rb)
 {
@@ -92,12 +102,10 @@ int db_table_exec_query(struct database *db, sv table_name,
             "cannot modify foreign table \"%s\"", t->name);
         return -1;
     }
-    /* COW trigger: save table state before first mutation in a transaction */
-    if (db->active_txn && db->active_txn->in_transaction && db->active_txn->snapshot &&
-        (q->query_type == QUERY_TYPE_INSERT || q->query_type == QUERY_TYPE_UPDATE ||
-         q->query_type == QUERY_TYPE_DELETE)) {
-        snapshot_cow_table(db->active_txn->snapshot, db, t->name);
-    }
+    /* undo trigger: log the rows this statement changes in a transaction */
+    if (q->query_type == QUERY_TYPE_INSERT || q->query_type == QUERY_TYPE_UPDATE ||
+        q->query_type == QUERY_TYPE_DELETE)
+        db_txn_note_write(db, t);
 #ifndef MSKQL_WASM
     /* Materialize Parquet data into flat storage */
     if (t->kind == TABLE_PARQUET && t->flat.nrows == 0)
@@ -291,70 +299,42 @@ static void build_merged_columns_ex(struct table *t1, const char *alias1,
     }
 }
 
-/* FNV-1a hash for a struct cell value (mirrors block_hash_cell in block.h).
+/* Hash a struct cell value with the block.h hash kernels.
  * Numeric types (INT, FLOAT, BIGINT, NUMERIC) are all hashed as double
  * so that INT(1) and FLOAT(1.0) produce the same hash — required for
  * correct cross-type equi-joins. */
 static uint32_t cell_hash(const struct cell *c)
 {
     if (c->is_null) return 0;
-    uint32_t h = FNV_OFFSET;
     switch (c->type) {
         case COLUMN_TYPE_SMALLINT:
+            return block_hash_f64((double)c->value.as_smallint);
         case COLUMN_TYPE_INT:
         case COLUMN_TYPE_BOOLEAN:
+            return block_hash_f64((double)c->value.as_int);
         case COLUMN_TYPE_BIGINT:
+            return block_hash_f64((double)c->value.as_bigint);
         case COLUMN_TYPE_FLOAT:
-        case COLUMN_TYPE_NUMERIC: {
-            double dv;
-            switch (c->type) {
-            case COLUMN_TYPE_SMALLINT: dv = (double)c->value.as_smallint; break;
-            case COLUMN_TYPE_INT:
-            case COLUMN_TYPE_BOOLEAN:  dv = (double)c->value.as_int; break;
-            case COLUMN_TYPE_BIGINT:   dv = (double)c->value.as_bigint; break;
-            case COLUMN_TYPE_FLOAT:
-            case COLUMN_TYPE_NUMERIC:  dv = c->value.as_float; break;
-            case COLUMN_TYPE_TEXT:
-            case COLUMN_TYPE_DATE:
-            case COLUMN_TYPE_TIME:
-            case COLUMN_TYPE_TIMESTAMP:
-            case COLUMN_TYPE_TIMESTAMPTZ:
-            case COLUMN_TYPE_INTERVAL:  dv = 0.0; break;
-            case COLUMN_TYPE_ENUM:      dv = (double)c->value.as_enum; break;
-            case COLUMN_TYPE_UUID:      dv = 0.0; break;
-            case COLUMN_TYPE_VECTOR:    dv = 0.0; break;
-            }
-            uint8_t *p = (uint8_t *)&dv;
-            for (int i = 0; i < (int)sizeof(double); i++) { h ^= p[i]; h *= FNV_PRIME; }
-            break;
-        }
+        case COLUMN_TYPE_NUMERIC:
+            return block_hash_f64(c->value.as_float);
         case COLUMN_TYPE_TEXT:
         case COLUMN_TYPE_DATE:
         case COLUMN_TYPE_TIME:
         case COLUMN_TYPE_TIMESTAMP:
         case COLUMN_TYPE_TIMESTAMPTZ:
         case COLUMN_TYPE_INTERVAL:
-            if (c->value.as_text) {
-                const char *s = c->value.as_text;
-                while (*s) { h ^= (uint8_t)*s++; h *= FNV_PRIME; }
-            }
-            break;
-        case COLUMN_TYPE_ENUM: {
-            uint8_t *p = (uint8_t *)&c->value.as_enum;
-            for (int i = 0; i < (int)sizeof(int32_t); i++) { h ^= p[i]; h *= FNV_PRIME; }
-            break;
-        }
+            return block_hash_str(c->value.as_text ? c->value.as_text : "");
+        case COLUMN_TYPE_ENUM:
+            return block_hash_i32(c->value.as_enum);
         case COLUMN_TYPE_UUID: {
             uint64_t uh = uuid_hash(c->value.as_uuid);
-            uint8_t *p = (uint8_t *)&uh;
-            for (int i = 0; i < (int)sizeof(uh); i++) { h ^= p[i]; h *= FNV_PRIME; }
-            break;
+            return (uint32_t)(uh ^ (uh >> 32));
         }
         case COLUMN_TYPE_VECTOR:
-            /* vectors are not join keys — hash as 0 */
-            break;
+            /* vectors are not join keys — hash to a constant */
+            return BLOCK_HASH_SEED;
     }
-    return h;
+    __builtin_unreachable();
 }
 
 /* perform a single join between two table descriptors, producing merged rows and columns */
@@ -1272,6 +1252,7 @@ static int exec_join_aggregate(struct database *db, struct query_select *s, stru
         rc = query_group_by(merged_t, s, a, result, rb, db);
     else
         rc = query_aggregate(merged_t, s, a, result, rb);
+    flat_table_free(&merged_t->flat);
     free_merged_rows(merged);
     free_merged_columns(merged_t);
     return rc;
@@ -1593,11 +1574,14 @@ void snapshot_free(struct db_snapshot *snap)
         free(snap->table_names[i]);
         if (snap->saved_valid[i])
             table_free(&snap->saved_tables[i]);
+        table_undo_free(&snap->undo_logs[i]);
     }
     free(snap->table_names);
     free(snap->table_generations);
     free(snap->saved_tables);
     free(snap->saved_valid);
+    free(snap->saved_clock);
+    free(snap->undo_logs);
     for (size_t i = 0; i < snap->types.count; i++)
         enum_type_free(&snap->types.items[i]);
     da_free(&snap->types);
@@ -1614,7 +1598,10 @@ struct db_snapshot *snapshot_create(struct database *db)
     snap->table_generations = malloc(n * sizeof(uint64_t));
     snap->saved_tables = calloc(n, sizeof(struct table));
     snap->saved_valid = calloc(n, sizeof(int));
-    if (!snap->table_names || !snap->table_generations || !snap->saved_tables || !snap->saved_valid) {
+    snap->saved_clock = calloc(n ? n : 1, sizeof(uint64_t));
+    snap->undo_logs = calloc(n ? n : 1, sizeof(struct table_undo));
+    if (!snap->table_names || !snap->table_generations || !snap->saved_tables ||
+        !snap->saved_valid || !snap->saved_clock || !snap->undo_logs) {
         fprintf(stderr, "OOM: snapshot_create\n"); abort();
     }
     for (size_t i = 0; i < n; i++) {
@@ -1634,34 +1621,99 @@ struct db_snapshot *snapshot_create(struct database *db)
     return snap;
 }
 
+/* Index of table_name among the tables snap saw at BEGIN, or -1. */
+static int snapshot_find(const struct db_snapshot *snap, const char *table_name)
+{
+    for (size_t i = 0; i < snap->orig_table_count; i++)
+        if (strcmp(snap->table_names[i], table_name) == 0)
+            return (int)i;
+    return -1;
+}
+
+/* 1 if owner is snap or one of the transactions snap is nested in. */
+static int snapshot_owns(const struct db_snapshot *snap, const void *owner)
+{
+    for (; snap; snap = snap->parent)
+        if (snap == owner) return 1;
+    return 0;
+}
+
 void snapshot_cow_table(struct db_snapshot *snap, struct database *db, const char *table_name)
 {
     if (!snap) return;
+    int i = snapshot_find(snap, table_name);
+    /* Table not in snapshot (created during transaction) — nothing to save */
+    if (i < 0) return;
+    struct table *t = db_find_table(db, table_name);
+    if (!t) return;
+    /* the copy covers every later change: stop logging them */
+    if (t->undo && snapshot_owns(snap, t->undo->owner))
+        t->undo = NULL;
+    if (snap->saved_valid[i]) return; /* already saved */
+    table_deep_copy(&snap->saved_tables[i], t);
+    snap->saved_valid[i] = 1;
+    snap->saved_clock[i] = table_undo_clock();
+}
+
+void snapshot_log_table(struct db_snapshot *snap, struct database *db, struct table *t)
+{
+    if (!snap) return;
+    int i = snapshot_find(snap, t->name);
+    if (i < 0 || snap->saved_valid[i]) return;
+    /* disk tables write through to their WAL; and a table another
+     * connection's transaction is logging keeps that one log */
+    if (t->kind != TABLE_MEMORY || (t->undo && !snapshot_owns(snap, t->undo->owner))) {
+        snapshot_cow_table(snap, db, t->name);
+        return;
+    }
+    table_undo_attach(t, &snap->undo_logs[i], snap);
+}
+
+/* Stop every table logging into snap (its logs are about to go away). */
+static void snapshot_detach(struct database *db, struct db_snapshot *snap)
+{
+    for (size_t i = 0; i < db->tables.count; i++)
+        if (db->tables.items[i].undo && db->tables.items[i].undo->owner == snap)
+            db->tables.items[i].undo = NULL;
+}
+
+/* A nested transaction committed: its parent must now be able to undo
+ * what it did.  Logs are appended to the parent's, and a table copy moves
+ * up unless the parent holds an older one (which then covers it). */
+static void snapshot_merge_into_parent(struct db_snapshot *snap)
+{
+    struct db_snapshot *parent = snap->parent;
     for (size_t i = 0; i < snap->orig_table_count; i++) {
-        if (strcmp(snap->table_names[i], table_name) == 0) {
-            if (snap->saved_valid[i]) return; /* already saved */
-            /* Find the table in the current database and deep-copy it */
-            struct table *t = db_find_table(db, table_name);
-            if (t) {
-                table_deep_copy(&snap->saved_tables[i], t);
-                snap->saved_valid[i] = 1;
-            }
-            return;
+        int j = snapshot_find(parent, snap->table_names[i]);
+        if (j < 0 || parent->saved_valid[j]) continue;
+        table_undo_append(&parent->undo_logs[j], &snap->undo_logs[i]);
+        if (snap->saved_valid[i]) {
+            parent->saved_tables[j] = snap->saved_tables[i];
+            parent->saved_valid[j] = 1;
+            parent->saved_clock[j] = snap->saved_clock[i];
+            memset(&snap->saved_tables[i], 0, sizeof(struct table));
+            snap->saved_valid[i] = 0;
         }
     }
-    /* Table not in snapshot (created during transaction) — nothing to save */
 }
 
-static void snapshot_restore(struct database *db, struct db_snapshot *snap)
+/* Put back every table snap saw at BEGIN.  Returns -1 if some row log
+ * could not be replayed (its table was rebuilt under it). */
+static int snapshot_restore(struct database *db, struct db_snapshot *snap)
 {
+    int rc = 0;
     /* Restore only the tables that were COW-saved */
     for (size_t i = 0; i < snap->orig_table_count; i++) {
         if (!snap->saved_valid[i]) continue;
         /* Find the table in the current database and replace it */
         struct table *t = db_find_table(db, snap->table_names[i]);
         if (t) {
-            table_free(t);
+            /* another transaction's log stays attached and skips what
+             * it recorded since the copy */
+            struct table old = *t;
             *t = snap->saved_tables[i];
+            table_undo_restored(t, &old, snap->saved_clock[i]);
+            table_free(&old);
             memset(&snap->saved_tables[i], 0, sizeof(struct table));
             snap->saved_valid[i] = 0;
         }
@@ -1688,17 +1740,30 @@ static void snapshot_restore(struct database *db, struct db_snapshot *snap)
         /* Table was saved but not found in current db — it was dropped */
         if (!db_find_table(db, snap->table_names[i])) {
             da_push(&db->tables, snap->saved_tables[i]);
+            table_undo_restored(&db->tables.items[db->tables.count - 1], NULL,
+                                snap->saved_clock[i]);
             db->total_generation++;
             memset(&snap->saved_tables[i], 0, sizeof(struct table));
             snap->saved_valid[i] = 0;
         }
     }
+    /* Replay the row logs backwards, after the copies they predate */
+    for (size_t i = 0; i < snap->orig_table_count; i++) {
+        struct table_undo *u = &snap->undo_logs[i];
+        if (u->recs.count == 0 && u->ncols == 0) continue;
+        struct table *t = db_find_table(db, snap->table_names[i]);
+        if (!t) continue;
+        if (table_undo_apply(t, u) != 0) { rc = -1; continue; }
+        t->generation++;
+        db->total_generation++;
+    }
     /* Restore types */
     for (size_t i = 0; i < db->types.count; i++)
         enum_type_free(&db->types.items[i]);
     da_free(&db->types);
     memcpy(&db->types, &snap->types, sizeof(db->types));
     memset(&snap->types, 0, sizeof(snap->types));
+    return rc;
 }
 
 /* Materialize a subquery into a temporary table added to db->tables.
@@ -1894,6 +1959,8 @@ struct table *materialize_subquery(struct database *db, const char *sql,
                 da_push(&db->tables, ct);
                 return &db->tables.items[db->tables.count - 1];
             }
+            /* the slow path must not see why planning gave up */
+            arena_clear_error(&sq.arena);
         }
     }
 
@@ -1911,6 +1978,8 @@ struct table *materialize_subquery(struct database *db, const char *sql,
                 plan_exec_init(&ctx, &sq.arena, db, pr.node);
                 plan_exec_to_rows(&ctx, pr.node, &sq_rows, NULL);
                 used_plan = 1;
+            } else {
+                arena_clear_error(&sq.arena);
             }
         }
     }
@@ -2097,6 +2166,9 @@ static int db_exec_commit(struct database *db, struct query *q)
         return 0;
     }
     struct db_snapshot *snap = txn->snapshot;
+    snapshot_detach(db, snap);
+    if (snap->parent)
+        snapshot_merge_into_parent(snap);
     txn->snapshot = snap->parent;
     snap->parent = NULL;
     snapshot_free(snap);
@@ -2114,11 +2186,17 @@ static int db_exec_rollback(struct database *db, struct query *q)
     }
     struct db_snapshot *snap = txn->snapshot;
     txn->snapshot = snap->parent;
+    int rc = snapshot_restore(db, snap);
+    snapshot_detach(db, snap);
     snap->parent = NULL;
-    snapshot_restore(db, snap);
     snapshot_free(snap);
     if (!txn->snapshot)
         txn->in_transaction = 0;
+    if (rc != 0) {
+        arena_set_error(&q->arena, "XX000",
+                        "ROLLBACK could not undo changes to a table rebuilt by another transaction");
+        return -1;
+    }
     return 0;
 }
 
@@ -2465,6 +2543,7 @@ static int insert_from_select(struct database *db, struct query *q, struct bump_
         free(sel_rows.data);
         return -1;
     }
+    db_txn_note_write(db, t);
     for (size_t i = 0; i < sel_rows.count; i++) {
         struct row r = {0};
         da_init(&r.cells);
@@ -2581,6 +2660,7 @@ static int insert_from_select(struct database *db, struct query *q, struct bump_
             }
         }
         table_flat_append_row(t, &r);
+        table_index_row(t, t->flat.nrows - 1);
         row_free(&r);
         t->generation++;
         db->total_generation++;
@@ -2604,6 +2684,7 @@ static int db_exec_insert(struct database *db, struct query *q, struct rows *res
         uint32_t orig_count = ins->insert_rows_count;
         struct table *t = db_find_table_sv(db, ins->table);
         if (t) {
+            db_txn_note_write(db, t);
             int conflict_col = -1;
             if (ins->conflict_column.len > 0)
                 conflict_col = table_find_column_sv(t, ins->conflict_column);
@@ -3984,9 +4065,7 @@ static int db_exec_delete(struct database *db, struct query *q,
             arena_set_error(arena, "42P01", "DELETE USING: table not found");
             return -1;
         }
-        /* COW trigger */
-        if (db->active_txn && db->active_txn->in_transaction && db->active_txn->snapshot)
-            snapshot_cow_table(db->active_txn->snapshot, db, dt->name);
+        db_txn_note_write(db, dt);
         /* build merged column metadata: t1 cols (qualified) + t2 cols (qualified) */
         struct table merged = {0};
         da_init(&merged.columns);
@@ -4033,21 +4112,22 @@ static int db_exec_delete(struct database *db, struct query *q,
                 if (match) { to_delete[i] = 1; break; }
             }
         }
-        /* delete matched rows (iterate backwards to avoid index shifting issues) */
+        /* tombstone the matched rows, then compact the table once */
         size_t deleted = 0;
-        for (size_t i = dt->flat.nrows; i > 0; i--) {
-            size_t idx = i - 1;
-            if (to_delete[idx]) {
-                table_flat_delete_row(dt, idx);
+        for (size_t i = 0; i < dt->flat.nrows; i++) {
+            if (to_delete[i]) {
+                table_flat_mark_deleted(dt, i);
                 deleted++;
-                dt->generation++;
-                db->total_generation++;
             }
         }
         free(to_delete);
+        if (deleted > 0) {
+            table_flat_purge_deleted(dt);
+            dt->generation++;
+            db->total_generation++;
+        }
         for (size_t c = 0; c < merged.columns.count; c++) free(merged.columns.items[c].name);
         da_free(&merged.columns);
-        /* indexes are rebuilt via generation change */
         /* store deleted count */
         if (result) {
             struct row r = {0};
@@ -4078,6 +4158,7 @@ static int db_exec_update(struct database *db, struct query *q,
             arena_set_error(arena, "42P01", "UPDATE FROM: table not found");
             return -1;
         }
+        db_txn_note_write(db, t);
         /* resolve join columns from the parsed WHERE t1.col = t2.col */
         int t_join_col = -1, ft_join_col = -1;
         if (u->update_from_join_left.len > 0 && u->update_from_join_right.len > 0) {
@@ -4491,9 +4572,9 @@ static int db_exec_show(struct database *db, struct query_show *sh,
                         struct query_arena *arena, struct rows *result,
                         struct bump_alloc *rb)
 {
-    (void)db;
     sv param = sh->parameter;
     const char *val = "";
+    char mem_buf[32];
     if (sv_eq_ignorecase_cstr(param, "search_path"))
         val = "\"$user\", public";
     else if (sv_eq_ignorecase_cstr(param, "server_version"))
@@ -4513,7 +4594,10 @@ static int db_exec_show(struct database *db, struct query_show *sh,
         val = "on";
     else if (sv_eq_ignorecase_cstr(param, "DateStyle"))
         val = "ISO, MDY";
-    else {
+    else if (sv_eq_ignorecase_cstr(param, "work_mem")) {
+        spill_format_mem(db->work_mem, mem_buf, sizeof(mem_buf));
+        val = mem_buf;
+    } else {
         arena_set_error(arena, "42704",
             "unrecognized configuration parameter \"%.*s\"",
             (int)param.len, param.data);
@@ -4529,6 +4613,27 @@ static int db_exec_show(struct database *db, struct query_show *sh,
     return 0;
 }
 
+/* SET / RESET: only work_mem takes effect; everything else is accepted
+ * and ignored for client compatibility. */
+static int db_exec_set(struct database *db, struct query_set *set,
+                       struct query_arena *arena)
+{
+    if (!sv_eq_ignorecase_cstr(set->parameter, "work_mem")) return 0;
+    if (set->value.len == 0 || sv_eq_ignorecase_cstr(set->value, "DEFAULT")) {
+        db->work_mem = spill_default_work_mem();
+        return 0;
+    }
+    size_t bytes;
+    if (spill_parse_mem(set->value.data, set->value.len, &bytes) != 0) {
+        arena_set_error(arena, "22023",
+            "invalid value for parameter \"work_mem\": \"%.*s\"",
+            (int)set->value.len, set->value.data);
+        return -1;
+    }
+    db->work_mem = bytes;
+    return 0;
+}
+
 #ifndef MSKQL_WASM
 static int db_exec_create_foreign_table(struct database *db,
                                         struct query_create_foreign_table *ft,
@@ -4592,7 +4697,7 @@ int db_exec(struct database *db, struct query *q, struct rows *result, struct bu
         case QUERY_TYPE_ROLLBACK:         return db_exec_rollback(db, q);
         case QUERY_TYPE_SHOW:             return db_exec_show(db, &q->show, &q->arena, result, rb);
         case QUERY_TYPE_COPY:             return 0; /* handled in pgwire */
-        case QUERY_TYPE_SET:
+        case QUERY_TYPE_SET:              return db_exec_set(db, &q->set, &q->arena);
         case QUERY_TYPE_ALTER_SEQUENCE:
         case QUERY_TYPE_SAVEPOINT:        return 0; /* no-op */
 #ifndef MSKQL_WASM
@@ -4943,12 +5048,23 @@ int db_needs_compaction(struct database *db)
         if (db->tables.items[i].kind == TABLE_DISK &&
             db->tables.items[i].disk.wal_dirty)
             return 1;
+        if (flat_strheap_wants_compact(db->tables.items[i].flat.str_heap))
+            return 1;
     }
     return 0;
 }
 
 int db_compact_step(struct database *db)
 {
+    /* reclaim dead TEXT values first: cheap, and purely in memory */
+    for (size_t i = 0; i < db->tables.count; i++) {
+        struct table *t = &db->tables.items[i];
+        if (!flat_strheap_wants_compact(t->flat.str_heap)) continue;
+        table_flat_compact_strings(t);
+        t->generation++;
+        db->total_generation++;
+        return 1;
+    }
     for (size_t i = 0; i < db->tables.count; i++) {
         struct table *t = &db->tables.items[i];
         if (t->kind != TABLE_DISK || !t->disk.wal_dirty) continue;
@@ -22,6 +22,10 @@ struct db_snapshot {
     uint64_t *table_generations; /* [orig_table_count] generation at BEGIN */
     struct table *saved_tables;  /* [orig_table_count] deep-copied on COW */
     int *saved_valid;            /* [orig_table_count] 1 if saved_tables[i] populated */
+    uint64_t *saved_clock;       /* [orig_table_count] table_undo_clock() at the copy */
+    /* [orig_table_count] row changes since BEGIN of tables not deep-copied
+     * (see "Transaction undo log" in table.h) */
+    struct table_undo *undo_logs;
     /* Types/sequences: small, just copy eagerly */
     DYNAMIC_ARRAY(struct enum_type) types;
     /* Nested transactions: pointer to parent snapshot */
@@ -49,6 +53,7 @@ struct database {
     uint64_t total_generation; /* sum of all table generations — bumped alongside t->generation++ */
     uint64_t catalog_generation; /* value of total_generation when catalog was last refreshed */
     char *catalog_path; /* path to disk table catalog file, or NULL if none */
+    size_t work_mem;    /* bytes a hash join/aggregate may hold before spilling (SET work_mem) */
 };
 
 void db_init(struct database *db, const char *name);
@@ -81,8 +86,14 @@ void snapshot_free(struct db_snapshot *snap);
  * Saves a deep-copy of the table if not already saved. */
 void snapshot_cow_table(struct db_snapshot *snap, struct database *db, const char *table_name);
 
+/* Row-change trigger: call before INSERT/UPDATE/DELETE on t inside a
+ * transaction.  An in-memory table gets its changed rows logged instead of
+ * being copied; other kinds fall back to snapshot_cow_table. */
+void snapshot_log_table(struct db_snapshot *snap, struct database *db, struct table *t);
+
 /* Disk table compaction: returns 1 if any table needs compaction, 0 otherwise.
- * db_compact_step compacts at most one dirty disk table per call (incremental). */
+ * db_compact_step compacts at most one dirty disk table, or one table's
+ * TEXT string heap, per call (incremental). */
 int db_needs_compaction(struct database *db);
 int db_compact_step(struct database *db);
 
@@ -250,6 +250,8 @@ int disk_load_cache(const char *path, struct disk_meta *meta,
         ft->col_vec_dims[c] = meta->cols[c].vec_dim;
     }
     flat_table_alloc_cols(ft);
+    ft->str_heap = flat_strheap_new();
+    flat_table_enable_str_pfx(ft);
 
     if (nrows == 0) { fclose(f); return 0; }
 
@@ -268,24 +270,24 @@ int disk_load_cache(const char *path, struct disk_meta *meta,
                 if (fread(ob, 1, 4, f) != 4) { free(offsets); goto fail; }
                 offsets[r] = read_u32_le(ob);
             }
-            /* Read string heap */
+            /* Read the column's strings straight into the table's string
+             * heap (as one chunk) and point each row at its value; WAL
+             * replay and later mutations allocate from the same heap. */
             size_t heap_size = meta->cols[c].data_size - nrows * sizeof(uint32_t);
-            char *heap = malloc(heap_size);
-            if (!heap) { free(offsets); goto fail; }
-            if (fread(heap, 1, heap_size, f) != heap_size) { free(offsets); free(heap); goto fail; }
+            char *heap = flat_strheap_alloc(ft->str_heap, heap_size);
+            if (fread(heap, 1, heap_size, f) != heap_size) { free(offsets); goto fail; }
+            ft->str_heap->live += heap_size;
 
-            /* strdup each string so flat_table owns all TEXT strings individually.
-             * This gives uniform ownership with WAL-replayed rows and mutations. */
             const char **strs = (const char **)ft->col_data[c];
             uint32_t *str_lens = ft->col_str_lens ? ft->col_str_lens[c] : NULL;
+            uint64_t *pfx = ft->col_str_pfx[c];
             for (uint64_t r = 0; r < nrows; r++) {
-                const char *src = heap + offsets[r];
-                strs[r] = strdup(src);
+                strs[r] = heap + offsets[r];
+                pfx[r] = str_pfx(strs[r]);
                 if (str_lens)
-                    str_lens[r] = (uint32_t)strlen(src);
+                    str_lens[r] = (uint32_t)strlen(strs[r]);
             }
             free(offsets);
-            free(heap);
         } else {
             /* Fixed-size: read packed array directly into col_data */
             size_t esz = col_type_elem_size(ct);
@@ -296,6 +298,10 @@ int disk_load_cache(const char *path, struct disk_meta *meta,
         /* Read null bitmap */
         if (fseek(f, (long)meta->cols[c].null_offset, SEEK_SET) != 0) goto fail;
         if (fread(ft->col_nulls[c], 1, nrows, f) != nrows) goto fail;
+        if (ct == COLUMN_TYPE_TEXT) {
+            for (uint64_t r = 0; r < nrows; r++)
+                if (ft->col_nulls[c][r]) flat_table_set_text(ft, c, r, NULL, 0);
+        }
     }
 
     ft->nrows = nrows;
@@ -401,7 +407,10 @@ static int wal_read_cell(FILE *f, struct flat_table *ft, uint16_t col,
     uint8_t is_null;
     if (fread(&is_null, 1, 1, f) != 1) return -1;
     ft->col_nulls[col][row_idx] = is_null;
-    if (is_null) return 0;
+    if (is_null) {
+        if (ct == COLUMN_TYPE_TEXT) flat_table_set_text(ft, col, row_idx, NULL, 0);
+        return 0;
+    }
 
     switch (column_type_storage(ct)) {
     case STORE_I16: {
@@ -435,8 +444,8 @@ static int wal_read_cell(FILE *f, struct flat_table *ft, uint16_t col,
         char *s = malloc(slen + 1);
         if (!s) return -1;
         if (slen > 0 && fread(s, 1, slen, f) != slen) { free(s); return -1; }
-        s[slen] = '\0';
-        ((char **)ft->col_data[col])[row_idx] = s;
+        flat_table_set_text(ft, col, row_idx, s, slen);
+        free(s);
         if (ft->col_str_lens && ft->col_str_lens[col])
             ft->col_str_lens[col][row_idx] = slen;
         break;
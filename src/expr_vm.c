@@ -0,0 +1,1285 @@
+#include "expr_vm.h"
+#include "query.h"
+#include "table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+/* ---- Compiler ---- */
+
+#define EVM_MAX_INSNS 256
+#define EVM_MAX_REGS  128
+#define EVM_MAX_SELS  64
+
+struct evm_builder {
+    struct query_arena     *arena;
+    struct table           *t;
+    const enum column_type *col_types;
+    uint16_t                ncols;
+    struct evm_insn         code[EVM_MAX_INSNS];
+    uint32_t                ncode;
+    enum column_type        reg_type[EVM_MAX_REGS];
+    int32_t                 reg_col[EVM_MAX_REGS];
+    uint8_t                 reg_null[EVM_MAX_REGS]; /* untyped NULL literal */
+    uint16_t                nregs;
+    uint8_t                 nsels;
+};
+
+typedef int (*evm_compile_fn)(struct evm_builder *b, uint32_t idx, int sel);
+
+static int evm_expr(struct evm_builder *b, uint32_t expr_idx, int sel);
+static int evm_cond(struct evm_builder *b, uint32_t cond_idx, int sel);
+
+/* Types a register can hold. */
+static int evm_type_ok(enum column_type t)
+{
+    switch (t) {
+    case COLUMN_TYPE_SMALLINT:
+    case COLUMN_TYPE_INT:
+    case COLUMN_TYPE_BIGINT:
+    case COLUMN_TYPE_FLOAT:
+    case COLUMN_TYPE_NUMERIC:
+    case COLUMN_TYPE_BOOLEAN:
+    case COLUMN_TYPE_TEXT:
+        return 1;
+    case COLUMN_TYPE_ENUM:
+    case COLUMN_TYPE_DATE:
+    case COLUMN_TYPE_TIME:
+    case COLUMN_TYPE_TIMESTAMP:
+    case COLUMN_TYPE_TIMESTAMPTZ:
+    case COLUMN_TYPE_INTERVAL:
+    case COLUMN_TYPE_UUID:
+    case COLUMN_TYPE_VECTOR:
+        return 0;
+    }
+    return 0;
+}
+
+static int evm_is_int(enum column_type t)
+{
+    return t == COLUMN_TYPE_SMALLINT || t == COLUMN_TYPE_INT || t == COLUMN_TYPE_BIGINT;
+}
+
+static int evm_is_flt(enum column_type t)
+{
+    return t == COLUMN_TYPE_FLOAT || t == COLUMN_TYPE_NUMERIC;
+}
+
+static int evm_is_num(enum column_type t)
+{
+    return evm_is_int(t) || evm_is_flt(t);
+}
+
+static int evm_new_reg(struct evm_builder *b, enum column_type type)
+{
+    if (b->nregs >= EVM_MAX_REGS) return -1;
+    uint16_t r = b->nregs++;
+    b->reg_type[r] = type;
+    b->reg_col[r] = -1;
+    b->reg_null[r] = 0;
+    return r;
+}
+
+static int evm_new_sel(struct evm_builder *b)
+{
+    if (b->nsels >= EVM_MAX_SELS) return -1;
+    return b->nsels++;
+}
+
+static struct evm_insn *evm_add(struct evm_builder *b, enum evm_opcode op,
+                                int sel, int dst)
+{
+    if (b->ncode >= EVM_MAX_INSNS || sel < 0 || dst < 0) return NULL;
+    struct evm_insn *in = &b->code[b->ncode++];
+    memset(in, 0, sizeof(*in));
+    in->op = op;
+    in->sel = (uint8_t)sel;
+    in->dst = (uint16_t)dst;
+    in->sel_out = EVM_NO_SEL;
+    in->sel_rest = EVM_NO_SEL;
+    return in;
+}
+
+/* Emit dst = op(a [, b]) into a fresh register of the given type. */
+static int evm_op(struct evm_builder *b, enum evm_opcode op, enum column_type type,
+                  int sel, int a, int bb, int arg)
+{
+    if (a < 0 || bb < -1) return -1;
+    int d = evm_new_reg(b, type);
+    struct evm_insn *in = evm_add(b, op, sel, d);
+    if (!in) return -1;
+    in->a = (uint16_t)a;
+    in->b = (uint16_t)(bb < 0 ? 0 : bb);
+    in->arg = arg;
+    return d;
+}
+
+/* Partition sel by register a into two new selections (rest may be NULL
+ * when the caller does not need the non-matching rows). */
+static int evm_split(struct evm_builder *b, int sel, int a, enum evm_split mode,
+                     int *out, int *rest)
+{
+    *out = evm_new_sel(b);
+    if (rest) *rest = evm_new_sel(b);
+    if (*out < 0 || (rest && *rest < 0) || a < 0) return -1;
+    struct evm_insn *in = evm_add(b, EVM_SPLIT, sel, 0);
+    if (!in) return -1;
+    in->a = (uint16_t)a;
+    in->arg = mode;
+    in->sel_out = (uint8_t)*out;
+    if (rest) in->sel_rest = (uint8_t)*rest;
+    return 0;
+}
+
+static int evm_column(struct evm_builder *b, int col)
+{
+    if (col < 0 || col >= b->ncols || !evm_type_ok(b->col_types[col])) return -1;
+    for (uint16_t r = 0; r < b->nregs; r++)
+        if (b->reg_col[r] == col) return r;
+    int r = evm_new_reg(b, b->col_types[col]);
+    if (r >= 0) b->reg_col[r] = col;
+    return r;
+}
+
+/* A NULL literal becomes an all-NULL INT register (what eval_expr yields for
+ * NULL arithmetic); reg_null lets CASE/COALESCE ignore it when typing. */
+static int evm_literal(struct evm_builder *b, const struct cell *c, int sel)
+{
+    int is_null = c->is_null || (column_type_is_text(c->type) && !c->value.as_text);
+    if (!is_null && !evm_type_ok(c->type)) return -1;
+    if (!is_null && c->type == COLUMN_TYPE_NUMERIC && c->numeric_scale > 0) return -1;
+    int r = evm_new_reg(b, is_null ? COLUMN_TYPE_INT : c->type);
+    struct evm_insn *in = evm_add(b, EVM_CONST, sel, r);
+    if (!in) return -1;
+    in->imm = *c;
+    in->imm.is_null = is_null;
+    b->reg_null[r] = (uint8_t)is_null;
+    return r;
+}
+
+static int evm_can_conv(enum column_type from, enum column_type to)
+{
+    if (from == to) return 1;
+    if (evm_is_num(from) && evm_is_num(to)) return 1;
+    if (to == COLUMN_TYPE_TEXT && (evm_is_num(from) || from == COLUMN_TYPE_BOOLEAN)) return 1;
+    return 0;
+}
+
+static int evm_conv(struct evm_builder *b, int r, enum column_type to,
+                    enum evm_text_fmt fmt, int sel)
+{
+    if (r < 0) return -1;
+    if (b->reg_type[r] == to) return r;
+    if (!evm_can_conv(b->reg_type[r], to)) return -1;
+    return evm_op(b, EVM_CONV, to, sel, r, -1, fmt);
+}
+
+/* Common type of two CASE / COALESCE results, or -1. */
+static int evm_unify(enum column_type a, enum column_type b)
+{
+    if (a == b) return (int)a;
+    if (evm_is_int(a) && evm_is_int(b)) {
+        if (a == COLUMN_TYPE_BIGINT || b == COLUMN_TYPE_BIGINT) return COLUMN_TYPE_BIGINT;
+        return COLUMN_TYPE_INT;
+    }
+    if (evm_is_flt(a) && evm_is_num(b)) return (int)a;
+    if (evm_is_num(a) && evm_is_flt(b)) return (int)b;
+    return -1;
+}
+
+/* Storage class cell_compare uses for a column/literal comparison, or -1
+ * when it would coerce (text vs number, temporal) or report incompatible. */
+static int evm_cell_cmp_type(enum column_type a, enum column_type b)
+{
+    if (evm_is_int(a) && evm_is_int(b)) return COLUMN_TYPE_BIGINT;
+    if ((a == COLUMN_TYPE_FLOAT || evm_is_int(a)) &&
+        (b == COLUMN_TYPE_FLOAT || evm_is_int(b))) return COLUMN_TYPE_FLOAT;
+    if (a == b && (a == COLUMN_TYPE_NUMERIC || a == COLUMN_TYPE_TEXT ||
+                   a == COLUMN_TYPE_BOOLEAN)) return (int)a;
+    return -1;
+}
+
+static enum evm_cmp evm_cmp_of_expr_op(enum expr_op op)
+{
+    if (op == OP_NE) return EVM_CMP_NE;
+    if (op == OP_LT) return EVM_CMP_LT;
+    if (op == OP_GT) return EVM_CMP_GT;
+    if (op == OP_LE) return EVM_CMP_LE;
+    if (op == OP_GE) return EVM_CMP_GE;
+    return EVM_CMP_EQ;
+}
+
+static int evm_cmp(struct evm_builder *b, int l, int r, int type,
+                   enum evm_cmp op, int null_false, int sel)
+{
+    if (type < 0) return -1;
+    l = evm_conv(b, l, (enum column_type)type, EVM_TEXT_CAST, sel);
+    r = evm_conv(b, r, (enum column_type)type, EVM_TEXT_CAST, sel);
+    if (l < 0 || r < 0) return -1;
+    int d = evm_op(b, EVM_CMP, COLUMN_TYPE_BOOLEAN, sel, l, r, op);
+    if (d >= 0) b->code[b->ncode - 1].arg2 = null_false;
+    return d;
+}
+
+/* Short-circuit AND / OR: the right operand only runs on rows the left one
+ * did not already decide. */
+static int evm_logic(struct evm_builder *b, int is_and, evm_compile_fn fn,
+                     uint32_t left, uint32_t right, int sel)
+{
+    int l = fn(b, left, sel);
+    if (l < 0 || b->reg_type[l] != COLUMN_TYPE_BOOLEAN) return -1;
+    int rs, cs;
+    if (evm_split(b, sel, l, is_and ? EVM_SPLIT_NOT_FALSE : EVM_SPLIT_NOT_TRUE,
+                  &rs, &cs) != 0) return -1;
+    int r = fn(b, right, rs);
+    if (r < 0 || b->reg_type[r] != COLUMN_TYPE_BOOLEAN) return -1;
+    int d = evm_new_reg(b, COLUMN_TYPE_BOOLEAN);
+    struct evm_insn *in = evm_add(b, EVM_CONST, cs, d);
+    if (!in) return -1;
+    in->imm.type = COLUMN_TYPE_BOOLEAN;
+    in->imm.value.as_bool = !is_and;
+    in = evm_add(b, is_and ? EVM_AND : EVM_OR, rs, d);
+    if (!in) return -1;
+    in->a = (uint16_t)l;
+    in->b = (uint16_t)r;
+    return d;
+}
+
+/* Write v into the shared result register dst of a CASE / COALESCE over sel,
+ * folding v's type into *type.  dst's type is fixed once every arm is seen. */
+static int evm_assign(struct evm_builder *b, int dst, int v, int sel, int *type)
+{
+    if (v < 0) return -1;
+    if (b->reg_null[v]) {
+        struct evm_insn *in = evm_add(b, EVM_CONST, sel, dst);
+        if (!in) return -1;
+        in->imm.is_null = 1;
+        return 0;
+    }
+    *type = *type < 0 ? (int)b->reg_type[v]
+                      : evm_unify((enum column_type)*type, b->reg_type[v]);
+    if (*type < 0) return -1;
+    struct evm_insn *in = evm_add(b, EVM_CONV, sel, dst);
+    if (!in) return -1;
+    in->a = (uint16_t)v;
+    in->arg = EVM_TEXT_CAST;
+    return 0;
+}
+
+static int evm_resolve_ref(struct evm_builder *b, const struct expr *e)
+{
+    if (!b->t) return -1;
+    int idx = -1;
+    if (e->column_ref.table.len > 0) {
+        char qname[256];
+        snprintf(qname, sizeof(qname), SV_FMT "." SV_FMT,
+                 SV_ARG(e->column_ref.table), SV_ARG(e->column_ref.column));
+        idx = table_find_column_sv(b->t, sv_from(qname, strlen(qname)));
+    }
+    if (idx < 0)
+        idx = table_find_column_sv(b->t, e->column_ref.column);
+    return idx;
+}
+
+static int evm_binary(struct evm_builder *b, const struct expr *e, int sel)
+{
+    enum expr_op op = e->binary.op;
+    if (op == OP_AND || op == OP_OR)
+        return evm_logic(b, op == OP_AND, evm_expr, e->binary.left, e->binary.right, sel);
+
+    int l = evm_expr(b, e->binary.left, sel);
+    int r = evm_expr(b, e->binary.right, sel);
+    if (l < 0 || r < 0) return -1;
+    enum column_type lt = b->reg_type[l], rt = b->reg_type[r];
+
+    if (op == OP_CONCAT) {
+        l = evm_conv(b, l, COLUMN_TYPE_TEXT, EVM_TEXT_CONCAT, sel);
+        r = evm_conv(b, r, COLUMN_TYPE_TEXT, EVM_TEXT_CONCAT, sel);
+        if (l < 0 || r < 0) return -1;
+        return evm_op(b, EVM_CONCAT, COLUMN_TYPE_TEXT, sel, l, r, 0);
+    }
+    if (op >= OP_EQ && op <= OP_GE) {
+        /* eval_binary_op compares text and booleans by their text form,
+         * which orders like the values only when both sides agree */
+        int type;
+        if (lt == COLUMN_TYPE_TEXT || rt == COLUMN_TYPE_TEXT ||
+            lt == COLUMN_TYPE_BOOLEAN || rt == COLUMN_TYPE_BOOLEAN)
+            type = lt == rt ? (int)lt : -1;
+        else if (evm_is_num(lt) && evm_is_num(rt))
+            type = (evm_is_flt(lt) || evm_is_flt(rt)) ? COLUMN_TYPE_FLOAT : COLUMN_TYPE_BIGINT;
+        else
+            type = -1;
+        return evm_cmp(b, l, r, type, evm_cmp_of_expr_op(op), 0, sel);
+    }
+    if (op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV ||
+        op == OP_MOD || op == OP_EXP) {
+        if (!evm_is_num(lt) || !evm_is_num(rt)) return -1;
+        enum column_type type;
+        if (op == OP_EXP || evm_is_flt(lt) || evm_is_flt(rt))
+            type = COLUMN_TYPE_FLOAT;
+        else if (lt == COLUMN_TYPE_BIGINT || rt == COLUMN_TYPE_BIGINT)
+            type = COLUMN_TYPE_BIGINT;
+        else
+            type = COLUMN_TYPE_INT;
+        l = evm_conv(b, l, type, EVM_TEXT_CAST, sel);
+        r = evm_conv(b, r, type, EVM_TEXT_CAST, sel);
+        return evm_op(b, EVM_ARITH, type, sel, l, r, op);
+    }
+    return -1;
+}
+
+static int evm_unary(struct evm_builder *b, const struct expr *e, int sel)
+{
+    int a = evm_expr(b, e->unary.operand, sel);
+    if (a < 0) return -1;
+    enum column_type t = b->reg_type[a];
+    if (e->unary.op == OP_NEG && evm_is_num(t))
+        return evm_op(b, EVM_NEG, t, sel, a, -1, 0);
+    if (e->unary.op == OP_NOT && t == COLUMN_TYPE_BOOLEAN)
+        return evm_op(b, EVM_NOT, t, sel, a, -1, 0);
+    return -1;
+}
+
+static int evm_coalesce(struct evm_builder *b, const struct expr *e, int sel)
+{
+    uint32_t nargs = e->func_call.args_count;
+    if (nargs == 0) return -1;
+    int dst = evm_new_reg(b, COLUMN_TYPE_INT);
+    if (dst < 0) return -1;
+    uint32_t first = b->ncode;
+    int type = -1;
+    int rem = sel;
+    for (uint32_t i = 0; i < nargs; i++) {
+        int v = evm_expr(b, FUNC_ARG(b->arena, e->func_call.args_start, i), rem);
+        if (evm_assign(b, dst, v, rem, &type) != 0) return -1;
+        if (i + 1 < nargs && evm_split(b, rem, v, EVM_SPLIT_NULL, &rem, NULL) != 0)
+            return -1;
+    }
+    if (type < 0) return -1;
+    b->reg_type[dst] = (enum column_type)type;
+    for (uint32_t pc = first; pc < b->ncode; pc++)
+        if (b->code[pc].op == EVM_CONV && b->code[pc].dst == dst &&
+            !evm_can_conv(b->reg_type[b->code[pc].a], (enum column_type)type))
+            return -1;
+    return dst;
+}
+
+static int evm_func(struct evm_builder *b, const struct expr *e, int sel)
+{
+    enum expr_func fn = e->func_call.func;
+    if (fn == FUNC_COALESCE) return evm_coalesce(b, e, sel);
+    if (e->func_call.args_count != 1) return -1;
+    if (fn != FUNC_UPPER && fn != FUNC_LOWER && fn != FUNC_LENGTH && fn != FUNC_ABS)
+        return -1;
+    int a = evm_expr(b, FUNC_ARG(b->arena, e->func_call.args_start, 0), sel);
+    if (a < 0) return -1;
+    enum column_type t = b->reg_type[a];
+    if (fn == FUNC_ABS) {
+        if (!evm_is_num(t)) return -1;
+        if (t != COLUMN_TYPE_INT && t != COLUMN_TYPE_BIGINT) t = COLUMN_TYPE_FLOAT;
+        return evm_op(b, EVM_ABS, t, sel, a, -1, 0);
+    }
+    if (t != COLUMN_TYPE_TEXT) return -1;
+    if (fn == FUNC_LENGTH) return evm_op(b, EVM_LENGTH, COLUMN_TYPE_INT, sel, a, -1, 0);
+    return evm_op(b, fn == FUNC_UPPER ? EVM_UPPER : EVM_LOWER, t, sel, a, -1, 0);
+}
+
+static int evm_case(struct evm_builder *b, const struct expr *e, int sel)
+{
+    int dst = evm_new_reg(b, COLUMN_TYPE_INT);
+    if (dst < 0) return -1;
+    uint32_t first = b->ncode;
+    int type = -1;
+    int rem = sel;
+    for (uint32_t i = 0; i < e->case_when.branches_count; i++) {
+        struct case_when_branch *br = &ABRANCH(b->arena, e->case_when.branches_start + i);
+        int c = evm_cond(b, br->cond_idx, rem);
+        int ts, rs;
+        if (c < 0 || evm_split(b, rem, c, EVM_SPLIT_TRUE, &ts, &rs) != 0) return -1;
+        if (evm_assign(b, dst, evm_expr(b, br->then_expr_idx, ts), ts, &type) != 0)
+            return -1;
+        rem = rs;
+    }
+    if (e->case_when.else_expr != IDX_NONE) {
+        if (evm_assign(b, dst, evm_expr(b, e->case_when.else_expr, rem), rem, &type) != 0)
+            return -1;
+    } else {
+        struct evm_insn *in = evm_add(b, EVM_CONST, rem, dst);
+        if (!in) return -1;
+        in->imm.is_null = 1;
+    }
+    if (type < 0) return -1;
+    b->reg_type[dst] = (enum column_type)type;
+    for (uint32_t pc = first; pc < b->ncode; pc++)
+        if (b->code[pc].op == EVM_CONV && b->code[pc].dst == dst &&
+            !evm_can_conv(b->reg_type[b->code[pc].a], (enum column_type)type))
+            return -1;
+    return dst;
+}
+
+static int evm_cast(struct evm_builder *b, const struct expr *e, int sel)
+{
+    enum column_type to = e->cast.target;
+    if (!evm_type_ok(to)) return -1;
+    if (to == COLUMN_TYPE_NUMERIC && (e->cast.scale >= 0 || e->cast.precision > 0))
+        return -1;
+    int a = evm_expr(b, e->cast.operand, sel);
+    if (a < 0) return -1;
+    if (b->reg_null[a]) {
+        int d = evm_new_reg(b, to);
+        struct evm_insn *in = evm_add(b, EVM_CONST, sel, d);
+        if (!in) return -1;
+        in->imm.is_null = 1;
+        return d;
+    }
+    return evm_conv(b, a, to, EVM_TEXT_CAST, sel);
+}
+
+static int evm_expr(struct evm_builder *b, uint32_t expr_idx, int sel)
+{
+    if (expr_idx == IDX_NONE || sel < 0) return -1;
+    const struct expr *e = &EXPR(b->arena, expr_idx);
+    switch (e->type) {
+    case EXPR_LITERAL:
+        return evm_literal(b, &e->literal, sel);
+    case EXPR_COLUMN_REF:
+        return evm_column(b, evm_resolve_ref(b, e));
+    case EXPR_BINARY_OP:
+        return evm_binary(b, e, sel);
+    case EXPR_UNARY_OP:
+        return evm_unary(b, e, sel);
+    case EXPR_FUNC_CALL:
+        return evm_func(b, e, sel);
+    case EXPR_CASE_WHEN:
+        return evm_case(b, e, sel);
+    case EXPR_CAST:
+        return evm_cast(b, e, sel);
+    case EXPR_IS_NULL:
+        return evm_op(b, EVM_IS_NULL, COLUMN_TYPE_BOOLEAN, sel,
+                      evm_expr(b, e->is_null.operand_is, sel), -1, e->is_null.negate);
+    case EXPR_SUBQUERY:
+    case EXPR_IS_DISTINCT:
+    case EXPR_EXISTS:
+    case EXPR_BETWEEN:
+    case EXPR_IN_LIST:
+    case EXPR_LIKE:
+        return -1;
+    }
+    return -1;
+}
+
+static int64_t evm_cell_i64(const struct cell *c)
+{
+    if (c->type == COLUMN_TYPE_SMALLINT) return c->value.as_smallint;
+    if (c->type == COLUMN_TYPE_INT) return c->value.as_int;
+    return c->value.as_bigint;
+}
+
+static double evm_cell_f64(const struct cell *c)
+{
+    if (evm_is_int(c->type)) return (double)evm_cell_i64(c);
+    return c->value.as_float;
+}
+
+static int evm_in(struct evm_builder *b, const struct condition *c, int l, int sel)
+{
+    enum column_type lt = b->reg_type[l];
+    int type = -1, has_null = 0;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < c->in_values_count; i++) {
+        const struct cell *iv = &ACELL(b->arena, c->in_values_start + i);
+        if (iv->is_null) { has_null = 1; continue; }
+        int t = evm_cell_cmp_type(lt, iv->type);
+        if (t < 0 || (type >= 0 && t != type)) return -1;
+        type = t;
+        n++;
+    }
+    if (type < 0) return -1;
+    l = evm_conv(b, l, (enum column_type)type, EVM_TEXT_CAST, sel);
+    if (l < 0) return -1;
+
+    struct bump_alloc *ba = &b->arena->scratch;
+    void *list = bump_alloc(ba, n * sizeof(int64_t) + 8);
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < c->in_values_count; i++) {
+        const struct cell *iv = &ACELL(b->arena, c->in_values_start + i);
+        if (iv->is_null) continue;
+        switch (column_type_storage((enum column_type)type)) {
+        case STORE_I32: ((int32_t *)list)[k++] = iv->value.as_bool; break;
+        case STORE_I64: ((int64_t *)list)[k++] = evm_cell_i64(iv); break;
+        case STORE_F64: ((double *)list)[k++] = evm_cell_f64(iv); break;
+        case STORE_STR: ((const char **)list)[k++] = iv->value.as_text; break;
+        case STORE_I16: case STORE_IV: case STORE_UUID: case STORE_VEC:
+            return -1;
+        }
+    }
+    int d = evm_op(b, EVM_IN, COLUMN_TYPE_BOOLEAN, sel, l, -1, c->op == CMP_NOT_IN);
+    if (d < 0) return -1;
+    struct evm_insn *in = &b->code[b->ncode - 1];
+    in->list = list;
+    in->nlist = n;
+    in->list_has_null = has_null;
+    return d;
+}
+
+static int evm_compare(struct evm_builder *b, const struct condition *c, int sel)
+{
+    if (c->subquery_sql != IDX_NONE || c->scalar_subquery_sql != IDX_NONE ||
+        c->is_any || c->is_all || !b->t)
+        return -1;
+    int l = -1;
+    if (c->column.len > 0) {
+        int col = table_find_column_sv(b->t, c->column);
+        if (col >= 0) l = evm_column(b, col);
+        else if (c->lhs_expr != IDX_NONE) l = evm_expr(b, c->lhs_expr, sel);
+    } else if (c->lhs_expr != IDX_NONE) {
+        l = evm_expr(b, c->lhs_expr, sel);
+    }
+    if (l < 0) return -1;
+    enum column_type lt = b->reg_type[l];
+
+    switch (c->op) {
+    case CMP_IS_NULL:
+    case CMP_IS_NOT_NULL:
+        return evm_op(b, EVM_IS_NULL, COLUMN_TYPE_BOOLEAN, sel, l, -1,
+                      c->op == CMP_IS_NOT_NULL);
+    case CMP_IN:
+    case CMP_NOT_IN:
+        return evm_in(b, c, l, sel);
+    case CMP_BETWEEN: {
+        if (c->value.is_null || c->between_high.is_null) return -1;
+        int lo = evm_literal(b, &c->value, sel);
+        int hi = evm_literal(b, &c->between_high, sel);
+        if (lo < 0 || hi < 0) return -1;
+        lo = evm_cmp(b, l, lo, evm_cell_cmp_type(lt, b->reg_type[lo]), EVM_CMP_GE, 0, sel);
+        hi = evm_cmp(b, l, hi, evm_cell_cmp_type(lt, b->reg_type[hi]), EVM_CMP_LE, 0, sel);
+        if (lo < 0 || hi < 0) return -1;
+        /* both bounds are NULL exactly when the operand is — plain AND */
+        return evm_op(b, EVM_AND, COLUMN_TYPE_BOOLEAN, sel, lo, hi, 0);
+    }
+    case CMP_LIKE:
+    case CMP_ILIKE: {
+        if (lt != COLUMN_TYPE_TEXT || c->value.type != COLUMN_TYPE_TEXT ||
+            c->value.is_null || !c->value.value.as_text)
+            return -1;
+        int d = evm_op(b, EVM_LIKE, COLUMN_TYPE_BOOLEAN, sel, l, -1, c->op == CMP_ILIKE);
+        if (d < 0) return -1;
+        struct evm_insn *in = &b->code[b->ncode - 1];
+        in->imm = c->value;
+        in->arg2 = c->escape_char ? c->escape_char : '\\';
+        return d;
+    }
+    case CMP_EQ:
+    case CMP_NE:
+    case CMP_LT:
+    case CMP_GT:
+    case CMP_LE:
+    case CMP_GE: {
+        enum evm_cmp op = (enum evm_cmp)(c->op - CMP_EQ);
+        if (c->rhs_column.len > 0) {
+            /* column-to-column: a NULL on either side is false, not unknown */
+            int r = evm_column(b, table_find_column_sv(b->t, c->rhs_column));
+            if (r < 0) return -1;
+            return evm_cmp(b, l, r, evm_cell_cmp_type(lt, b->reg_type[r]), op, 1, sel);
+        }
+        if (c->value.is_null) return -1;
+        int r = evm_literal(b, &c->value, sel);
+        if (r < 0) return -1;
+        return evm_cmp(b, l, r, evm_cell_cmp_type(lt, b->reg_type[r]), op, 0, sel);
+    }
+    case CMP_IS_DISTINCT:
+    case CMP_IS_NOT_DISTINCT:
+    case CMP_EXISTS:
+    case CMP_NOT_EXISTS:
+    case CMP_REGEX_MATCH:
+    case CMP_REGEX_NOT_MATCH:
+    case CMP_REGEX_ICASE_MATCH:
+    case CMP_REGEX_ICASE_NOT_MATCH:
+    case CMP_IS_NOT_TRUE:
+    case CMP_IS_NOT_FALSE:
+    case CMP_SIMILAR_TO:
+    case CMP_NOT_SIMILAR_TO:
+        return -1;
+    }
+    return -1;
+}
+
+static int evm_cond(struct evm_builder *b, uint32_t cond_idx, int sel)
+{
+    if (cond_idx == IDX_NONE || sel < 0) return -1;
+    const struct condition *c = &COND(b->arena, cond_idx);
+    switch (c->type) {
+    case COND_AND:
+    case COND_OR:
+        return evm_logic(b, c->type == COND_AND, evm_cond, c->left, c->right, sel);
+    case COND_NOT: {
+        int a = evm_cond(b, c->left, sel);
+        if (a < 0 || b->reg_type[a] != COLUMN_TYPE_BOOLEAN) return -1;
+        return evm_op(b, EVM_NOT, COLUMN_TYPE_BOOLEAN, sel, a, -1, 0);
+    }
+    case COND_COMPARE:
+        return evm_compare(b, c, sel);
+    case COND_MULTI_IN:
+        return -1;
+    }
+    return -1;
+}
+
+static struct evm_prog *evm_compile(struct query_arena *arena, struct table *t,
+                                    uint32_t idx, int is_cond,
+                                    const enum column_type *col_types, uint16_t ncols)
+{
+    struct evm_builder *b = (struct evm_builder *)calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    b->arena = arena;
+    b->t = t;
+    b->col_types = col_types;
+    b->ncols = ncols;
+    b->nsels = 1; /* selection 0: the block's active rows */
+
+    int result = is_cond ? evm_cond(b, idx, 0) : evm_expr(b, idx, 0);
+    struct evm_prog *p = NULL;
+    if (result >= 0 && !b->reg_null[result] &&
+        (!is_cond || b->reg_type[result] == COLUMN_TYPE_BOOLEAN)) {
+        struct bump_alloc *ba = &arena->scratch;
+        p = (struct evm_prog *)bump_calloc(ba, 1, sizeof(*p));
+        p->code = (struct evm_insn *)bump_alloc(ba, b->ncode * sizeof(struct evm_insn));
+        memcpy(p->code, b->code, b->ncode * sizeof(struct evm_insn));
+        p->ncode = b->ncode;
+        p->reg_type = (enum column_type *)bump_alloc(ba, b->nregs * sizeof(enum column_type));
+        memcpy(p->reg_type, b->reg_type, b->nregs * sizeof(enum column_type));
+        p->reg_col = (int32_t *)bump_alloc(ba, b->nregs * sizeof(int32_t));
+        memcpy(p->reg_col, b->reg_col, b->nregs * sizeof(int32_t));
+        p->nregs = b->nregs;
+        p->nsels = b->nsels;
+        p->result = (uint16_t)result;
+    }
+    free(b);
+    return p;
+}
+
+struct evm_prog *evm_compile_expr(struct query_arena *arena, struct table *t,
+                                  uint32_t expr_idx,
+                                  const enum column_type *col_types,
+                                  uint16_t ncols)
+{
+    return evm_compile(arena, t, expr_idx, 0, col_types, ncols);
+}
+
+struct evm_prog *evm_compile_cond(struct query_arena *arena, struct table *t,
+                                  uint32_t cond_idx,
+                                  const enum column_type *col_types,
+                                  uint16_t ncols)
+{
+    return evm_compile(arena, t, cond_idx, 1, col_types, ncols);
+}
+
+/* ---- Runtime ---- */
+
+int evm_inputs_match(const struct evm_prog *p, const struct row_block *blk)
+{
+    for (uint16_t r = 0; r < p->nregs; r++) {
+        int32_t col = p->reg_col[r];
+        if (col < 0) continue;
+        if (col >= blk->ncols || blk->cols[col].type != p->reg_type[r]) return 0;
+    }
+    return 1;
+}
+
+struct evm_state *evm_state_new(const struct evm_prog *p, struct bump_alloc *alloc)
+{
+    struct evm_state *st = (struct evm_state *)bump_calloc(alloc, 1, sizeof(*st));
+    st->prog = p;
+    st->nulls = (uint8_t **)bump_calloc(alloc, p->nregs, sizeof(uint8_t *));
+    st->vals = (void **)bump_calloc(alloc, p->nregs, sizeof(void *));
+    st->text_nulls = (uint8_t **)bump_calloc(alloc, p->nregs, sizeof(uint8_t *));
+    for (uint16_t r = 0; r < p->nregs; r++) {
+        if (p->reg_col[r] < 0) {
+            st->nulls[r] = (uint8_t *)bump_alloc(alloc, BLOCK_CAPACITY);
+            st->vals[r] = bump_alloc(alloc, BLOCK_CAPACITY * col_type_elem_size(p->reg_type[r]));
+        } else if (p->reg_type[r] == COLUMN_TYPE_TEXT) {
+            st->text_nulls[r] = (uint8_t *)bump_alloc(alloc, BLOCK_CAPACITY);
+        }
+    }
+    st->sel = (uint32_t **)bump_calloc(alloc, p->nsels, sizeof(uint32_t *));
+    st->nsel = (uint16_t *)bump_calloc(alloc, p->nsels, sizeof(uint16_t));
+    for (uint8_t s = 0; s < p->nsels; s++)
+        st->sel[s] = (uint32_t *)bump_alloc(alloc, BLOCK_CAPACITY * sizeof(uint32_t));
+    return st;
+}
+
+static double evm_load_f64(enum storage_class sc, const void *v, uint32_t i)
+{
+    switch (sc) {
+    case STORE_I16: return (double)((const int16_t *)v)[i];
+    case STORE_I32: return (double)((const int32_t *)v)[i];
+    case STORE_I64: return (double)((const int64_t *)v)[i];
+    case STORE_F64: return ((const double *)v)[i];
+    case STORE_STR: case STORE_IV: case STORE_UUID: case STORE_VEC: break;
+    }
+    return 0.0;
+}
+
+static void evm_op_const(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    uint8_t *dn = st->nulls[in->dst];
+    void *dv = st->vals[in->dst];
+    const struct cell *c = &in->imm;
+    for (uint16_t k = 0; k < n; k++) dn[s[k]] = (uint8_t)c->is_null;
+    if (c->is_null) return;
+    switch (column_type_storage(st->prog->reg_type[in->dst])) {
+    case STORE_I16:
+        for (uint16_t k = 0; k < n; k++) ((int16_t *)dv)[s[k]] = c->value.as_smallint;
+        break;
+    case STORE_I32: {
+        int32_t v = c->type == COLUMN_TYPE_BOOLEAN ? c->value.as_bool : c->value.as_int;
+        for (uint16_t k = 0; k < n; k++) ((int32_t *)dv)[s[k]] = v;
+        break;
+    }
+    case STORE_I64:
+        for (uint16_t k = 0; k < n; k++) ((int64_t *)dv)[s[k]] = c->value.as_bigint;
+        break;
+    case STORE_F64:
+        for (uint16_t k = 0; k < n; k++) ((double *)dv)[s[k]] = c->value.as_float;
+        break;
+    case STORE_STR:
+        for (uint16_t k = 0; k < n; k++) ((char **)dv)[s[k]] = c->value.as_text;
+        break;
+    case STORE_IV: case STORE_UUID: case STORE_VEC:
+        break;
+    }
+}
+
+/* Number / boolean → text, matching eval_cast (%g) or cell_format_buf. */
+static size_t evm_format(enum column_type t, const void *v, uint32_t i,
+                         enum evm_text_fmt fmt, char *buf, size_t bufsz)
+{
+    int n = 0;
+    switch (column_type_storage(t)) {
+    case STORE_I16: n = snprintf(buf, bufsz, "%d", (int)((const int16_t *)v)[i]); break;
+    case STORE_I32:
+        if (t == COLUMN_TYPE_BOOLEAN)
+            n = snprintf(buf, bufsz, "%s", ((const int32_t *)v)[i] ? "true" : "false");
+        else
+            n = snprintf(buf, bufsz, "%d", ((const int32_t *)v)[i]);
+        break;
+    case STORE_I64: n = snprintf(buf, bufsz, "%lld", (long long)((const int64_t *)v)[i]); break;
+    case STORE_F64: {
+        double d = ((const double *)v)[i];
+        if (fmt == EVM_TEXT_CAST) {
+            n = snprintf(buf, bufsz, "%g", d);
+        } else {
+            n = snprintf(buf, bufsz, "%.15g", d);
+            if (t == COLUMN_TYPE_NUMERIC && (strchr(buf, 'e') || strchr(buf, 'E')))
+                n = snprintf(buf, bufsz, "%.2f", d);
+        }
+        break;
+    }
+    case STORE_STR: case STORE_IV: case STORE_UUID: case STORE_VEC:
+        buf[0] = '\0';
+        break;
+    }
+    return n < 0 ? 0 : (size_t)n;
+}
+
+static int evm_op_conv(struct evm_state *st, const struct evm_insn *in,
+                       struct query_arena *arena)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    enum column_type from = st->prog->reg_type[in->a];
+    enum column_type to = st->prog->reg_type[in->dst];
+    const uint8_t *an = st->nulls[in->a];
+    uint8_t *dn = st->nulls[in->dst];
+    const void *av = st->vals[in->a];
+    void *dv = st->vals[in->dst];
+    for (uint16_t k = 0; k < n; k++) dn[s[k]] = an[s[k]];
+
+    if (from == to || (evm_is_flt(from) && evm_is_flt(to))) {
+        size_t esz = col_type_elem_size(to);
+        for (uint16_t k = 0; k < n; k++)
+            memcpy((char *)dv + s[k] * esz, (const char *)av + s[k] * esz, esz);
+        return 0;
+    }
+    if (to == COLUMN_TYPE_TEXT) {
+        char buf[64];
+        for (uint16_t k = 0; k < n; k++) {
+            uint32_t i = s[k];
+            if (an[i]) continue;
+            size_t len = evm_format(from, av, i, (enum evm_text_fmt)in->arg, buf, sizeof(buf));
+            ((char **)dv)[i] = bump_strndup(&arena->scratch, buf, len);
+        }
+        return 0;
+    }
+
+    enum storage_class fs = column_type_storage(from);
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        if (an[i]) continue;
+        switch (to) {
+        case COLUMN_TYPE_FLOAT:
+        case COLUMN_TYPE_NUMERIC:
+            ((double *)dv)[i] = evm_load_f64(fs, av, i);
+            break;
+        case COLUMN_TYPE_BIGINT:
+            if (fs == STORE_I16) { ((int64_t *)dv)[i] = ((const int16_t *)av)[i]; break; }
+            if (fs == STORE_I32) { ((int64_t *)dv)[i] = ((const int32_t *)av)[i]; break; }
+            {
+                double rv = round(evm_load_f64(fs, av, i));
+                if (rv < -9223372036854775808.0 || rv > 9223372036854775807.0) {
+                    arena_set_error(arena, "22003", "bigint out of range");
+                    return -1;
+                }
+                ((int64_t *)dv)[i] = (int64_t)rv;
+            }
+            break;
+        case COLUMN_TYPE_INT:
+            if (fs == STORE_I16) { ((int32_t *)dv)[i] = ((const int16_t *)av)[i]; break; }
+            {
+                double rv = round(evm_load_f64(fs, av, i));
+                if (rv < -2147483648.0 || rv > 2147483647.0) {
+                    arena_set_error(arena, "22003", "integer out of range");
+                    return -1;
+                }
+                ((int32_t *)dv)[i] = (int32_t)rv;
+            }
+            break;
+        case COLUMN_TYPE_SMALLINT: {
+            double v = evm_load_f64(fs, av, i);
+            if (v < -32768.0 || v > 32767.0) {
+                arena_set_error(arena, "22003", "smallint out of range");
+                return -1;
+            }
+            ((int16_t *)dv)[i] = (int16_t)v;
+            break;
+        }
+        case COLUMN_TYPE_BOOLEAN:
+        case COLUMN_TYPE_TEXT:
+        case COLUMN_TYPE_ENUM:
+        case COLUMN_TYPE_DATE:
+        case COLUMN_TYPE_TIME:
+        case COLUMN_TYPE_TIMESTAMP:
+        case COLUMN_TYPE_TIMESTAMPTZ:
+        case COLUMN_TYPE_INTERVAL:
+        case COLUMN_TYPE_UUID:
+        case COLUMN_TYPE_VECTOR:
+            break;
+        }
+    }
+    return 0;
+}
+
+#define EVM_BINARY_LOOP(BODY)                         \
+    for (uint16_t k = 0; k < n; k++) {                \
+        uint32_t i = s[k];                            \
+        if (an[i] | bn[i]) { dn[i] = 1; continue; }   \
+        dn[i] = 0;                                    \
+        BODY;                                         \
+    }
+
+static int evm_op_arith(struct evm_state *st, const struct evm_insn *in,
+                        struct query_arena *arena)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a], *bn = st->nulls[in->b];
+    uint8_t *dn = st->nulls[in->dst];
+    enum expr_op op = (enum expr_op)in->arg;
+
+    switch (column_type_storage(st->prog->reg_type[in->dst])) {
+    case STORE_I32: {
+        /* INT arithmetic wraps like the row evaluator's C int math */
+        const int32_t *x = st->vals[in->a], *y = st->vals[in->b];
+        int32_t *d = st->vals[in->dst];
+        if (op == OP_ADD) EVM_BINARY_LOOP(d[i] = (int32_t)((uint32_t)x[i] + (uint32_t)y[i]))
+        else if (op == OP_SUB) EVM_BINARY_LOOP(d[i] = (int32_t)((uint32_t)x[i] - (uint32_t)y[i]))
+        else if (op == OP_MUL) EVM_BINARY_LOOP(d[i] = (int32_t)((uint32_t)x[i] * (uint32_t)y[i]))
+        else if (op == OP_DIV)
+            EVM_BINARY_LOOP(if (y[i] == 0) goto div0;
+                            d[i] = y[i] == -1 ? (int32_t)(0u - (uint32_t)x[i]) : x[i] / y[i])
+        else if (op == OP_MOD)
+            EVM_BINARY_LOOP(if (y[i] == 0) goto div0;
+                            d[i] = y[i] == -1 ? 0 : x[i] % y[i])
+        return 0;
+    }
+    case STORE_I64: {
+        const int64_t *x = st->vals[in->a], *y = st->vals[in->b];
+        int64_t *d = st->vals[in->dst];
+        if (op == OP_ADD) EVM_BINARY_LOOP(if (__builtin_add_overflow(x[i], y[i], &d[i])) goto range)
+        else if (op == OP_SUB) EVM_BINARY_LOOP(if (__builtin_sub_overflow(x[i], y[i], &d[i])) goto range)
+        else if (op == OP_MUL) EVM_BINARY_LOOP(if (__builtin_mul_overflow(x[i], y[i], &d[i])) goto range)
+        else if (op == OP_DIV)
+            EVM_BINARY_LOOP(if (y[i] == 0) goto div0;
+                            if (y[i] == -1 && x[i] == INT64_MIN) goto range;
+                            d[i] = x[i] / y[i])
+        else if (op == OP_MOD)
+            EVM_BINARY_LOOP(if (y[i] == 0) goto div0;
+                            d[i] = y[i] == -1 ? 0 : x[i] % y[i])
+        return 0;
+    }
+    case STORE_F64: {
+        /* IEEE 754: float division by zero yields ±Infinity, not an error */
+        const double *x = st->vals[in->a], *y = st->vals[in->b];
+        double *d = st->vals[in->dst];
+        if (op == OP_ADD) EVM_BINARY_LOOP(d[i] = x[i] + y[i])
+        else if (op == OP_SUB) EVM_BINARY_LOOP(d[i] = x[i] - y[i])
+        else if (op == OP_MUL) EVM_BINARY_LOOP(d[i] = x[i] * y[i])
+        else if (op == OP_DIV) EVM_BINARY_LOOP(d[i] = x[i] / y[i])
+        else if (op == OP_MOD) EVM_BINARY_LOOP(d[i] = fmod(x[i], y[i]))
+        else if (op == OP_EXP) EVM_BINARY_LOOP(d[i] = pow(x[i], y[i]))
+        return 0;
+    }
+    case STORE_I16: case STORE_STR: case STORE_IV: case STORE_UUID: case STORE_VEC:
+        return 0;
+    }
+    return 0;
+
+div0:
+    arena_set_error(arena, "22012", "division by zero");
+    return -1;
+range:
+    arena_set_error(arena, "22003", "bigint out of range");
+    return -1;
+}
+
+#define EVM_CMP_CASES(X, Y)                                                   \
+    switch ((enum evm_cmp)in->arg) {                                          \
+    case EVM_CMP_EQ: EVM_CMP_LOOP((X) == (Y)) break;                          \
+    case EVM_CMP_NE: EVM_CMP_LOOP((X) != (Y)) break;                          \
+    case EVM_CMP_LT: EVM_CMP_LOOP((X) <  (Y)) break;                          \
+    case EVM_CMP_GT: EVM_CMP_LOOP((X) >  (Y)) break;                          \
+    case EVM_CMP_LE: EVM_CMP_LOOP((X) <= (Y)) break;                          \
+    case EVM_CMP_GE: EVM_CMP_LOOP((X) >= (Y)) break;                          \
+    }
+
+#define EVM_CMP_LOOP(TEST)                                                    \
+    for (uint16_t k = 0; k < n; k++) {                                        \
+        uint32_t i = s[k];                                                    \
+        if (an[i] | bn[i]) { dn[i] = !null_false; d[i] = 0; continue; }      \
+        dn[i] = 0;                                                            \
+        d[i] = (TEST);                                                        \
+    }
+
+static void evm_op_cmp(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a], *bn = st->nulls[in->b];
+    uint8_t *dn = st->nulls[in->dst];
+    int32_t *d = st->vals[in->dst];
+    int null_false = in->arg2;
+
+    switch (column_type_storage(st->prog->reg_type[in->a])) {
+    case STORE_I32: {
+        const int32_t *x = st->vals[in->a], *y = st->vals[in->b];
+        EVM_CMP_CASES(x[i], y[i])
+        break;
+    }
+    case STORE_I64: {
+        const int64_t *x = st->vals[in->a], *y = st->vals[in->b];
+        EVM_CMP_CASES(x[i], y[i])
+        break;
+    }
+    case STORE_F64: {
+        const double *x = st->vals[in->a], *y = st->vals[in->b];
+        EVM_CMP_CASES(x[i], y[i])
+        break;
+    }
+    case STORE_STR: {
+        char *const *x = st->vals[in->a], *const *y = st->vals[in->b];
+        EVM_CMP_CASES(strcmp(x[i], y[i]), 0)
+        break;
+    }
+    case STORE_I16: case STORE_IV: case STORE_UUID: case STORE_VEC:
+        break;
+    }
+}
+
+static void evm_op_logic(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a], *bn = st->nulls[in->b];
+    uint8_t *dn = st->nulls[in->dst];
+    const int32_t *x = st->vals[in->a], *y = st->vals[in->b];
+    int32_t *d = st->vals[in->dst];
+    /* the dominant value (FALSE for AND, TRUE for OR) wins over NULL */
+    int32_t dom = in->op == EVM_OR;
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        int xv = an[i] ? -1 : (x[i] != 0);
+        int yv = bn[i] ? -1 : (y[i] != 0);
+        if (xv == dom || yv == dom) { dn[i] = 0; d[i] = dom; }
+        else if (xv < 0 || yv < 0)  { dn[i] = 1; d[i] = 0; }
+        else                        { dn[i] = 0; d[i] = !dom; }
+    }
+}
+
+static void evm_op_unary(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a];
+    uint8_t *dn = st->nulls[in->dst];
+    const void *av = st->vals[in->a];
+    void *dv = st->vals[in->dst];
+    enum column_type at = st->prog->reg_type[in->a];
+
+    if (in->op == EVM_IS_NULL) {
+        for (uint16_t k = 0; k < n; k++) {
+            dn[s[k]] = 0;
+            ((int32_t *)dv)[s[k]] = an[s[k]] ^ (in->arg != 0);
+        }
+        return;
+    }
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        dn[i] = an[i];
+        if (an[i]) continue;
+        if (in->op == EVM_NOT) {
+            ((int32_t *)dv)[i] = !((const int32_t *)av)[i];
+        } else if (in->op == EVM_NEG) {
+            switch (column_type_storage(at)) {
+            case STORE_I16: ((int16_t *)dv)[i] = (int16_t)(0u - (uint16_t)((const int16_t *)av)[i]); break;
+            case STORE_I32: ((int32_t *)dv)[i] = (int32_t)(0u - (uint32_t)((const int32_t *)av)[i]); break;
+            case STORE_I64: ((int64_t *)dv)[i] = (int64_t)(0ull - (uint64_t)((const int64_t *)av)[i]); break;
+            case STORE_F64: ((double *)dv)[i] = -((const double *)av)[i]; break;
+            case STORE_STR: case STORE_IV: case STORE_UUID: case STORE_VEC: break;
+            }
+        } else if (in->op == EVM_ABS) {
+            if (at == COLUMN_TYPE_INT) {
+                int32_t v = ((const int32_t *)av)[i];
+                ((int32_t *)dv)[i] = v < 0 ? (int32_t)(0u - (uint32_t)v) : v;
+            } else if (at == COLUMN_TYPE_BIGINT) {
+                int64_t v = ((const int64_t *)av)[i];
+                ((int64_t *)dv)[i] = v < 0 ? (int64_t)(0ull - (uint64_t)v) : v;
+            } else {
+                double v = evm_load_f64(column_type_storage(at), av, i);
+                ((double *)dv)[i] = v < 0 ? -v : v;
+            }
+        }
+    }
+}
+
+static void evm_op_text(struct evm_state *st, const struct evm_insn *in,
+                        struct query_arena *arena)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a];
+    uint8_t *dn = st->nulls[in->dst];
+    char *const *x = st->vals[in->a];
+
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        dn[i] = an[i];
+        if (in->op == EVM_CONCAT) dn[i] |= st->nulls[in->b][i];
+        if (dn[i]) continue;
+        size_t len = strlen(x[i]);
+        if (in->op == EVM_LENGTH) {
+            ((int32_t *)st->vals[in->dst])[i] = (int32_t)len;
+        } else if (in->op == EVM_CONCAT) {
+            const char *y = ((char *const *)st->vals[in->b])[i];
+            size_t ylen = strlen(y);
+            char *buf = (char *)bump_alloc(&arena->scratch, len + ylen + 1);
+            memcpy(buf, x[i], len);
+            memcpy(buf + len, y, ylen + 1);
+            ((char **)st->vals[in->dst])[i] = buf;
+        } else {
+            char *buf = (char *)bump_alloc(&arena->scratch, len + 1);
+            int up = in->op == EVM_UPPER;
+            for (size_t j = 0; j <= len; j++) {
+                unsigned char ch = (unsigned char)x[i][j];
+                buf[j] = (char)(up ? toupper(ch) : tolower(ch));
+            }
+            ((char **)st->vals[in->dst])[i] = buf;
+        }
+    }
+}
+
+static void evm_op_in(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a];
+    uint8_t *dn = st->nulls[in->dst];
+    int32_t *d = st->vals[in->dst];
+    const void *av = st->vals[in->a];
+    enum storage_class sc = column_type_storage(st->prog->reg_type[in->a]);
+    int negate = in->arg;
+
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        if (an[i]) { dn[i] = 1; d[i] = 0; continue; }
+        int found = 0;
+        for (uint32_t j = 0; j < in->nlist && !found; j++) {
+            switch (sc) {
+            case STORE_I32: found = ((const int32_t *)av)[i] == ((const int32_t *)in->list)[j]; break;
+            case STORE_I64: found = ((const int64_t *)av)[i] == ((const int64_t *)in->list)[j]; break;
+            case STORE_F64: found = ((const double *)av)[i] == ((const double *)in->list)[j]; break;
+            case STORE_STR:
+                found = strcmp(((char *const *)av)[i], ((const char *const *)in->list)[j]) == 0;
+                break;
+            case STORE_I16: case STORE_IV: case STORE_UUID: case STORE_VEC: break;
+            }
+        }
+        /* NOT IN with a NULL in the list and no match is UNKNOWN */
+        dn[i] = !found && negate && in->list_has_null;
+        d[i] = found ? !negate : negate;
+    }
+}
+
+static void evm_op_like(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a];
+    uint8_t *dn = st->nulls[in->dst];
+    int32_t *d = st->vals[in->dst];
+    char *const *x = st->vals[in->a];
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        dn[i] = an[i];
+        d[i] = an[i] ? 0 : like_match_esc(in->imm.value.as_text, x[i], in->arg, (char)in->arg2);
+    }
+}
+
+static void evm_op_split(struct evm_state *st, const struct evm_insn *in)
+{
+    const uint32_t *s = st->sel[in->sel];
+    uint16_t n = st->nsel[in->sel];
+    const uint8_t *an = st->nulls[in->a];
+    const int32_t *x = st->vals[in->a];
+    uint32_t *out = st->sel[in->sel_out];
+    uint32_t *rest = in->sel_rest == EVM_NO_SEL ? NULL : st->sel[in->sel_rest];
+    uint16_t no = 0, nr = 0;
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        int take = 0;
+        switch ((enum evm_split)in->arg) {
+        case EVM_SPLIT_TRUE:      take = !an[i] && x[i];  break;
+        case EVM_SPLIT_NOT_FALSE: take = an[i] || x[i];   break;
+        case EVM_SPLIT_NOT_TRUE:  take = an[i] || !x[i];  break;
+        case EVM_SPLIT_NULL:      take = an[i];           break;
+        }
+        if (take) out[no++] = i;
+        else if (rest) rest[nr++] = i;
+    }
+    st->nsel[in->sel_out] = no;
+    if (rest) st->nsel[in->sel_rest] = nr;
+}
+
+int evm_run(struct evm_state *st, const struct row_block *blk,
+            struct query_arena *arena)
+{
+    const struct evm_prog *p = st->prog;
+
+    uint32_t *s0 = st->sel[0];
+    if (blk->sel) {
+        memcpy(s0, blk->sel, blk->sel_count * sizeof(uint32_t));
+        st->nsel[0] = blk->sel_count;
+    } else {
+        for (uint16_t i = 0; i < blk->count; i++) s0[i] = i;
+        st->nsel[0] = blk->count;
+    }
+
+    /* bind input columns in place; TEXT also treats a NULL pointer as NULL */
+    for (uint16_t r = 0; r < p->nregs; r++) {
+        if (p->reg_col[r] < 0) continue;
+        const struct col_block *cb = &blk->cols[p->reg_col[r]];
+        st->vals[r] = cb_data_ptr(cb, 0);
+        st->nulls[r] = (uint8_t *)cb_nulls(cb);
+        if (p->reg_type[r] == COLUMN_TYPE_TEXT) {
+            char *const *str = st->vals[r];
+            uint8_t *tn = st->text_nulls[r];
+            for (uint16_t k = 0; k < st->nsel[0]; k++) {
+                uint32_t i = s0[k];
+                tn[i] = st->nulls[r][i] || !str[i];
+            }
+            st->nulls[r] = tn;
+        }
+    }
+
+    for (uint32_t pc = 0; pc < p->ncode; pc++) {
+        const struct evm_insn *in = &p->code[pc];
+        switch (in->op) {
+        case EVM_CONST:   evm_op_const(st, in); break;
+        case EVM_CONV:    if (evm_op_conv(st, in, arena) != 0) return -1; break;
+        case EVM_ARITH:   if (evm_op_arith(st, in, arena) != 0) return -1; break;
+        case EVM_CMP:     evm_op_cmp(st, in); break;
+        case EVM_AND:
+        case EVM_OR:      evm_op_logic(st, in); break;
+        case EVM_NOT:
+        case EVM_IS_NULL:
+        case EVM_NEG:
+        case EVM_ABS:     evm_op_unary(st, in); break;
+        case EVM_UPPER:
+        case EVM_LOWER:
+        case EVM_LENGTH:
+        case EVM_CONCAT:  evm_op_text(st, in, arena); break;
+        case EVM_IN:      evm_op_in(st, in); break;
+        case EVM_LIKE:    evm_op_like(st, in); break;
+        case EVM_SPLIT:   evm_op_split(st, in); break;
+        }
+    }
+    return 0;
+}
+
+void evm_emit(const struct evm_state *st, struct col_block *out,
+              struct bump_alloc *alloc)
+{
+    const struct evm_prog *p = st->prog;
+    const uint32_t *s = st->sel[0];
+    uint16_t n = st->nsel[0];
+    const uint8_t *rn = st->nulls[p->result];
+    const void *rv = st->vals[p->result];
+
+    out->type = p->reg_type[p->result];
+    out->count = n;
+    out->borrowed = 0;
+    for (uint16_t k = 0; k < n; k++) out->nulls[k] = rn[s[k]];
+    switch (column_type_storage(out->type)) {
+    case STORE_I16:
+        for (uint16_t k = 0; k < n; k++) out->data.i16[k] = ((const int16_t *)rv)[s[k]];
+        break;
+    case STORE_I32:
+        for (uint16_t k = 0; k < n; k++) out->data.i32[k] = ((const int32_t *)rv)[s[k]];
+        break;
+    case STORE_I64:
+        for (uint16_t k = 0; k < n; k++) out->data.i64[k] = ((const int64_t *)rv)[s[k]];
+        break;
+    case STORE_F64:
+        for (uint16_t k = 0; k < n; k++) out->data.f64[k] = ((const double *)rv)[s[k]];
+        break;
+    case STORE_STR:
+        out->str_lens = (uint32_t *)bump_alloc(alloc, BLOCK_CAPACITY * sizeof(uint32_t));
+        for (uint16_t k = 0; k < n; k++) {
+            char *str = out->nulls[k] ? NULL : ((char *const *)rv)[s[k]];
+            out->data.str[k] = str;
+            out->str_lens[k] = str ? (uint32_t)strlen(str) : 0;
+        }
+        break;
+    case STORE_IV: case STORE_UUID: case STORE_VEC:
+        break;
+    }
+}
+
+uint16_t evm_select(const struct evm_state *st, uint32_t *sel)
+{
+    const struct evm_prog *p = st->prog;
+    const uint32_t *s = st->sel[0];
+    uint16_t n = st->nsel[0];
+    const uint8_t *rn = st->nulls[p->result];
+    const int32_t *rv = st->vals[p->result];
+    uint16_t m = 0;
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t i = s[k];
+        if (!rn[i] && rv[i]) sel[m++] = i;
+    }
+    return m;
+}
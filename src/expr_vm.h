@@ -0,0 +1,151 @@
+#ifndef EXPR_VM_H
+#define EXPR_VM_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "block.h"
+
+struct table;
+
+/* ---- Expression bytecode VM ----
+ *
+ * Compiles an expression or WHERE condition tree into a flat,
+ * register-based program once per query and evaluates it over whole
+ * col_block vectors: one dispatch per instruction per block instead of an
+ * eval_expr tree walk per row.  Registers are typed BLOCK_CAPACITY vectors
+ * indexed by the input row index; input columns are bound in place, so
+ * borrowed (zero-copy) scan blocks are read without materializing them.
+ *
+ * Every instruction runs over a selection vector.  CASE, COALESCE and
+ * AND/OR split the selection they run over, so each branch only evaluates
+ * the rows that reach it: a THEN arm that would divide by zero on rows it
+ * never sees raises no error, exactly like the row-at-a-time evaluator.
+ *
+ * Compilation mirrors eval_expr / eval_condition semantics for the subset
+ * it accepts and returns NULL (without setting an error) for anything
+ * else — subqueries, temporal types, most functions — so callers keep the
+ * per-row path for those.  Result types are static: arithmetic with a
+ * BIGINT operand is BIGINT, any FLOAT/NUMERIC operand makes it FLOAT. */
+
+enum evm_opcode {
+    EVM_CONST,      /* dst = imm */
+    EVM_CONV,       /* dst = a converted to dst's type (arg: evm_text_fmt) */
+    EVM_ARITH,      /* dst = a <arg: expr_op> b */
+    EVM_CMP,        /* dst = a <arg: evm_cmp> b (arg2: NULL compares false) */
+    EVM_AND,        /* dst = a AND b (three-valued) */
+    EVM_OR,         /* dst = a OR b (three-valued) */
+    EVM_NOT,        /* dst = NOT a */
+    EVM_IS_NULL,    /* dst = a IS NULL (arg: negate) */
+    EVM_NEG,        /* dst = -a */
+    EVM_ABS,        /* dst = ABS(a) */
+    EVM_UPPER,      /* dst = UPPER(a) */
+    EVM_LOWER,      /* dst = LOWER(a) */
+    EVM_LENGTH,     /* dst = LENGTH(a) */
+    EVM_CONCAT,     /* dst = a || b */
+    EVM_IN,         /* dst = a IN list (arg: negate) */
+    EVM_LIKE,       /* dst = a LIKE imm (arg: case-insensitive, arg2: escape) */
+    EVM_SPLIT       /* partition sel by a (arg: evm_split) into sel_out / sel_rest */
+};
+
+enum evm_cmp {
+    EVM_CMP_EQ,
+    EVM_CMP_NE,
+    EVM_CMP_LT,
+    EVM_CMP_GT,
+    EVM_CMP_LE,
+    EVM_CMP_GE
+};
+
+enum evm_split {
+    EVM_SPLIT_TRUE,      /* rows where a is TRUE */
+    EVM_SPLIT_NOT_FALSE, /* rows where a is TRUE or NULL */
+    EVM_SPLIT_NOT_TRUE,  /* rows where a is FALSE or NULL */
+    EVM_SPLIT_NULL       /* rows where a is NULL */
+};
+
+/* Number → text rendering used by EVM_CONV: CAST(x AS TEXT) uses %g,
+ * the || operator uses the cell_format_buf rendering (%.15g). */
+enum evm_text_fmt {
+    EVM_TEXT_CAST,
+    EVM_TEXT_CONCAT
+};
+
+#define EVM_NO_SEL 0xFF
+
+struct evm_insn {
+    enum evm_opcode op;
+    int             arg;
+    int             arg2;
+    uint16_t        dst, a, b;     /* register numbers */
+    uint8_t         sel;           /* selection the instruction runs over */
+    uint8_t         sel_out;       /* EVM_SPLIT: matching rows, or EVM_NO_SEL */
+    uint8_t         sel_rest;      /* EVM_SPLIT: other rows, or EVM_NO_SEL */
+    struct cell     imm;           /* EVM_CONST value / EVM_LIKE pattern */
+    const void     *list;          /* EVM_IN: values in a's storage class */
+    uint32_t        nlist;
+    int             list_has_null;
+};
+
+struct evm_prog {
+    struct evm_insn  *code;
+    uint32_t          ncode;
+    enum column_type *reg_type;    /* [nregs] */
+    int32_t          *reg_col;     /* [nregs] bound input column, or -1 */
+    uint16_t          nregs;
+    uint8_t           nsels;
+    uint16_t          result;      /* register holding the final value */
+};
+
+/* Per-executor evaluation state (register and selection buffers).
+ * Not shared between workers — each gets its own from evm_state_new. */
+struct evm_state {
+    const struct evm_prog *prog;
+    uint8_t  **nulls;              /* [nregs] */
+    void     **vals;               /* [nregs] */
+    uint8_t  **text_nulls;         /* [nregs] TEXT inputs: NULL-pointer-aware copy */
+    uint32_t **sel;                /* [nsels] */
+    uint16_t  *nsel;               /* [nsels] */
+};
+
+/* Compile expression expr_idx against rows whose columns have the given
+ * types (column names are resolved through t).  Returns NULL when the
+ * expression uses anything the VM does not cover.  Allocates from
+ * arena->scratch. */
+struct evm_prog *evm_compile_expr(struct query_arena *arena, struct table *t,
+                                  uint32_t expr_idx,
+                                  const enum column_type *col_types,
+                                  uint16_t ncols);
+
+/* Same for a WHERE condition; the program yields a BOOLEAN where NULL is
+ * UNKNOWN.  Use evm_select to turn it into a selection vector. */
+struct evm_prog *evm_compile_cond(struct query_arena *arena, struct table *t,
+                                  uint32_t cond_idx,
+                                  const enum column_type *col_types,
+                                  uint16_t ncols);
+
+/* Type of the value a program produces. */
+static inline enum column_type evm_result_type(const struct evm_prog *p)
+{
+    return p->reg_type[p->result];
+}
+
+/* 1 if every input column the program reads has the compiled type in blk. */
+int evm_inputs_match(const struct evm_prog *p, const struct row_block *blk);
+
+struct evm_state *evm_state_new(const struct evm_prog *p, struct bump_alloc *alloc);
+
+/* Evaluate the program over the active rows of blk.  Text results are
+ * allocated from arena->scratch.  Returns 0, or -1 with the arena error set
+ * (division by zero, out-of-range cast, ...). */
+int evm_run(struct evm_state *st, const struct row_block *blk,
+            struct query_arena *arena);
+
+/* Copy the result of the last evm_run into out, compacted to the active
+ * rows in order (out->count = number of active rows). */
+void evm_emit(const struct evm_state *st, struct col_block *out,
+              struct bump_alloc *alloc);
+
+/* Write the active rows whose result is TRUE into sel; returns the count. */
+uint16_t evm_select(const struct evm_state *st, uint32_t *sel);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MSKQL_WASM
+#define _GNU_SOURCE   /* mremap */
+#endif
+
+#include "block.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef MSKQL_WASM
+#include <sys/mman.h>
+#endif
+
+/* ---- Flat column memory (see block.h) ---- */
+
+#ifndef MSKQL_WASM
+
+static int flat_mem_mapped(size_t nbytes)
+{
+    return nbytes >= FLAT_MEM_MAP_MIN;
+}
+
+void *flat_mem_alloc(size_t nbytes)
+{
+    if (!flat_mem_mapped(nbytes)) {
+        void *p = calloc(1, nbytes ? nbytes : 1);
+        if (!p) { fprintf(stderr, "OOM: flat_mem_alloc\n"); abort(); }
+        return p;
+    }
+    /* anonymous pages read as zero and cost nothing until written */
+    void *p = mmap(NULL, nbytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) { fprintf(stderr, "OOM: flat_mem_alloc\n"); abort(); }
+    return p;
+}
+
+void *flat_mem_grow(void *p, size_t old_bytes, size_t new_bytes)
+{
+    if (!flat_mem_mapped(new_bytes)) {
+        void *np = realloc(p, new_bytes ? new_bytes : 1);
+        if (!np) { fprintf(stderr, "OOM: flat_mem_grow\n"); abort(); }
+        memset((char *)np + old_bytes, 0, new_bytes - old_bytes);
+        return np;
+    }
+    if (!flat_mem_mapped(old_bytes)) {
+        /* leaving the malloc heap: the one copy this array ever gets */
+        void *np = flat_mem_alloc(new_bytes);
+        memcpy(np, p, old_bytes);
+        free(p);
+        return np;
+    }
+    /* The kernel extends the mapping in place or moves its page table
+     * entries; the rows themselves are never copied, and the new tail is
+     * zero like any fresh anonymous memory. */
+    void *np = mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE);
+    if (np == MAP_FAILED) { fprintf(stderr, "OOM: flat_mem_grow\n"); abort(); }
+    return np;
+}
+
+void flat_mem_free(void *p, size_t nbytes)
+{
+    if (!p) return;
+    if (flat_mem_mapped(nbytes)) munmap(p, nbytes);
+    else free(p);
+}
+
+#else /* MSKQL_WASM: no mmap, everything lives on the malloc heap */
+
+void *flat_mem_alloc(size_t nbytes)
+{
+    void *p = calloc(1, nbytes ? nbytes : 1);
+    if (!p) { fprintf(stderr, "OOM: flat_mem_alloc\n"); abort(); }
+    return p;
+}
+
+void *flat_mem_grow(void *p, size_t old_bytes, size_t new_bytes)
+{
+    void *np = realloc(p, new_bytes ? new_bytes : 1);
+    if (!np) { fprintf(stderr, "OOM: flat_mem_grow\n"); abort(); }
+    memset((char *)np + old_bytes, 0, new_bytes - old_bytes);
+    return np;
+}
+
+void flat_mem_free(void *p, size_t nbytes)
+{
+    (void)nbytes;
+    free(p);
+}
+
+#endif /* MSKQL_WASM */
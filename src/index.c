@@ -207,6 +207,58 @@ void index_remove(struct index *idx, const struct cell *keys, size_t row_id)
     }
 }
 
+/* returns the number of entries left without row ids */
+static size_t node_remap_rows(struct btree_node *node, const uint64_t *del_bits,
+                              const size_t *del_rank)
+{
+    if (!node) return 0;
+    size_t emptied = 0;
+    for (size_t i = 0; i < node->count; i++) {
+        struct btree_entry *e = &node->entries[i];
+        size_t n = 0;
+        for (size_t j = 0; j < e->row_ids.count; j++) {
+            size_t id = e->row_ids.items[j];
+            uint64_t w = del_bits[id >> 6];
+            if ((w >> (id & 63)) & 1) continue;
+            uint64_t below = w & (((uint64_t)1 << (id & 63)) - 1);
+            e->row_ids.items[n++] = id - del_rank[id >> 6] - (size_t)__builtin_popcountll(below);
+        }
+        e->row_ids.count = n;
+        if (n == 0) emptied++;
+    }
+    if (!node->is_leaf) {
+        for (size_t i = 0; i <= node->count; i++)
+            emptied += node_remap_rows(node->children[i], del_bits, del_rank);
+    }
+    return emptied;
+}
+
+/* re-insert the row ids of every non-empty entry under node, in key order */
+static void node_reinsert(struct index *idx, struct btree_node *node)
+{
+    if (!node) return;
+    for (size_t i = 0; i <= node->count; i++) {
+        if (!node->is_leaf)
+            node_reinsert(idx, node->children[i]);
+        if (i == node->count) break;
+        struct btree_entry *e = &node->entries[i];
+        for (size_t j = 0; j < e->row_ids.count; j++)
+            index_insert(idx, e->keys, e->row_ids.items[j]);
+    }
+}
+
+void index_remap_rows(struct index *idx, const uint64_t *del_bits, const size_t *del_rank)
+{
+    if (idx->type != INDEX_BTREE) return;
+    if (node_remap_rows(idx->root, del_bits, del_rank) == 0) return;
+    /* keys whose rows were all deleted: rebuild from the live entries
+     * rather than unlinking them one by one */
+    struct btree_node *old = idx->root;
+    idx->root = node_alloc(1);
+    node_reinsert(idx, old);
+    node_free(old, idx->ncols);
+}
+
 void index_reset(struct index *idx)
 {
     switch (idx->type) {
@@ -229,6 +281,94 @@ void index_reset(struct index *idx)
     }
 }
 
+/* ---- range cursor ---- */
+
+static int key_is_null(const struct cell *c)
+{
+    return c->is_null || (column_type_is_text(c->type) && !c->value.as_text);
+}
+
+static int above_lo(const struct index_range *r, const struct btree_entry *e)
+{
+    if (r->lo_n == 0) return 1;
+    int cmp = cells_compare(e->keys, r->lo, r->lo_n);
+    return r->lo_incl ? cmp >= 0 : cmp > 0;
+}
+
+static int below_hi(const struct index_range *r, const struct btree_entry *e)
+{
+    if (r->hi_n == 0) return 1;
+    int cmp = cells_compare(e->keys, r->hi, r->hi_n);
+    return r->hi_incl ? cmp <= 0 : cmp < 0;
+}
+
+static void cursor_push(struct index_cursor *cur, struct btree_node *node, size_t pos)
+{
+    if (cur->depth == INDEX_CURSOR_DEPTH) {
+        fprintf(stderr, "index_cursor: tree deeper than %d\n", INDEX_CURSOR_DEPTH);
+        abort();
+    }
+    cur->stack[cur->depth].node = node;
+    cur->stack[cur->depth].pos = pos;
+    cur->depth++;
+}
+
+/* push the path to the first (ascending) or last (descending) entry of node */
+static void cursor_descend(struct index_cursor *cur, struct btree_node *node)
+{
+    while (node) {
+        size_t pos = cur->desc ? node->count : 0;
+        cursor_push(cur, node, pos);
+        node = node->is_leaf ? NULL : node->children[pos];
+    }
+}
+
+void index_cursor_open(struct index_cursor *cur, struct index *idx,
+                       const struct index_range *r, int desc)
+{
+    cur->range = *r;
+    cur->desc = desc;
+    cur->depth = 0;
+    struct btree_node *node = idx->type == INDEX_BTREE ? idx->root : NULL;
+    /* Seek: in every node on the way down, skip the entries (and the
+     * subtrees left of them) that lie wholly before the start bound. */
+    while (node) {
+        size_t i = 0;
+        if (!desc) {
+            while (i < node->count && !above_lo(r, &node->entries[i])) i++;
+        } else {
+            while (i < node->count && below_hi(r, &node->entries[i])) i++;
+        }
+        cursor_push(cur, node, i);
+        node = node->is_leaf ? NULL : node->children[i];
+    }
+}
+
+const struct btree_entry *index_cursor_next(struct index_cursor *cur)
+{
+    const struct index_range *r = &cur->range;
+    while (cur->depth > 0) {
+        struct btree_node *node = cur->stack[cur->depth - 1].node;
+        size_t *pos = &cur->stack[cur->depth - 1].pos;
+        const struct btree_entry *e;
+        if (!cur->desc) {
+            if (*pos == node->count) { cur->depth--; continue; }
+            e = &node->entries[(*pos)++];
+            if (!node->is_leaf) cursor_descend(cur, node->children[*pos]);
+            if (!below_hi(r, e)) { cur->depth = 0; return NULL; }
+        } else {
+            if (*pos == 0) { cur->depth--; continue; }
+            e = &node->entries[--(*pos)];
+            if (!node->is_leaf) cursor_descend(cur, node->children[*pos]);
+            if (!above_lo(r, e)) { cur->depth = 0; return NULL; }
+        }
+        if (r->null_col >= 0 && key_is_null(&e->keys[r->null_col])) continue;
+        if (e->row_ids.count == 0) continue;
+        return e;
+    }
+    return NULL;
+}
+
 void index_free(struct index *idx)
 {
     free(idx->name);
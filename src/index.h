@@ -47,6 +47,49 @@ int  index_lookup(struct index *idx, const struct cell *keys,
                   size_t **out_ids, size_t *out_count);
 void index_remove(struct index *idx, const struct cell *keys, size_t row_id);
 void index_reset(struct index *idx);
+/* B-tree only: renumber row ids after the rows set in del_bits were removed
+ * from the table.  Ids of removed rows are dropped and the rest move down
+ * by the number of removed rows before them; del_rank[w] counts the bits
+ * set in del_bits[0..w).  Keys left without rows are dropped (the tree is
+ * rebuilt from the surviving entries). */
+void index_remap_rows(struct index *idx, const uint64_t *del_bits, const size_t *del_rank);
 void index_free(struct index *idx);
 
+/* ---- Range and ordered scans ----
+ *
+ * A cursor walks a B-tree index in key order, or backwards with desc,
+ * between two optional bounds.  Each bound is a key prefix of lo_n / hi_n
+ * leading columns compared with cells_compare; NULL keys sort after every
+ * value.  With null_col >= 0, entries whose key column null_col is NULL are
+ * skipped, since no range predicate on that column matches NULL.  The
+ * cursor points into the tree: the index must not change while it is in
+ * use. */
+
+#define INDEX_CURSOR_DEPTH 32
+
+struct index_range {
+    struct cell lo[MAX_INDEX_COLS];
+    struct cell hi[MAX_INDEX_COLS];
+    int lo_n, hi_n;          /* 0 = unbounded */
+    int lo_incl, hi_incl;
+    int null_col;            /* -1 = keep NULL keys */
+};
+
+struct index_cursor {
+    struct index_range range;
+    int desc;
+    int depth;
+    /* ascending: entries[pos] is next in node; descending: entries[pos - 1] */
+    struct {
+        struct btree_node *node;
+        size_t pos;
+    } stack[INDEX_CURSOR_DEPTH];
+};
+
+/* Position the cursor before the first entry of r (in desc order, the last). */
+void index_cursor_open(struct index_cursor *cur, struct index *idx,
+                       const struct index_range *r, int desc);
+/* Next entry with at least one row id, or NULL when the range is exhausted. */
+const struct btree_entry *index_cursor_next(struct index_cursor *cur);
+
 #endif
@@ -0,0 +1,110 @@
+#include "parallel.h"
+
+#ifndef MSKQL_WASM
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+/* ---- worker count ---- */
+
+static int par_cached_nworkers = 0;
+
+int par_nworkers(void)
+{
+    if (par_cached_nworkers > 0) return par_cached_nworkers;
+    int n = 1;
+#ifndef MSKQL_WASM
+    const char *env = getenv("MSKQL_THREADS");
+    if (env && *env) n = atoi(env);
+    if (n <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        n = ncpu > 0 ? (int)ncpu : 1;
+    }
+#endif
+    if (n < 1) n = 1;
+    if (n > PAR_MAX_WORKERS) n = PAR_MAX_WORKERS;
+    par_cached_nworkers = n;
+    return n;
+}
+
+/* ---- fork-join ---- */
+
+#ifndef MSKQL_WASM
+/* Pool threads are started on first use and live for the rest of the
+ * process.  par_run publishes a job under pool_mu and bumps pool_gen;
+ * every pool thread wakes, runs its share if its id is below pool_njob,
+ * and the last one to finish signals pool_done.  pool_busy admits one job
+ * at a time — a par_run issued while a job is running (from inside a
+ * task) runs serially instead of waiting on the pool. */
+static pthread_mutex_t pool_busy = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_mu   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  pool_done = PTHREAD_COND_INITIALIZER;
+static int         pool_nthreads;   /* pool workers started: ids 1..pool_nthreads */
+static uint64_t    pool_gen;        /* bumped once per job */
+static par_task_fn pool_fn;
+static void       *pool_arg;
+static int         pool_njob;       /* worker ids below this take part */
+static int         pool_pending;    /* pool workers still running the job */
+
+static void *par_pool_main(void *p)
+{
+    int w = (int)(intptr_t)p;
+    /* gen 0 is never a job: a thread started for job g runs it at once */
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool_mu);
+    for (;;) {
+        while (pool_gen == seen)
+            pthread_cond_wait(&pool_wake, &pool_mu);
+        seen = pool_gen;
+        if (w >= pool_njob) continue;
+        par_task_fn fn = pool_fn;
+        void *arg = pool_arg;
+        pthread_mutex_unlock(&pool_mu);
+        fn(arg, w);
+        pthread_mutex_lock(&pool_mu);
+        if (--pool_pending == 0)
+            pthread_cond_signal(&pool_done);
+    }
+    return NULL;
+}
+#endif
+
+void par_run(int nworkers, par_task_fn fn, void *arg)
+{
+    if (nworkers > PAR_MAX_WORKERS) nworkers = PAR_MAX_WORKERS;
+#ifndef MSKQL_WASM
+    if (nworkers > 1 && pthread_mutex_trylock(&pool_busy) == 0) {
+        pthread_mutex_lock(&pool_mu);
+        while (pool_nthreads < nworkers - 1) {
+            pthread_t tid;
+            int w = pool_nthreads + 1;
+            if (pthread_create(&tid, NULL, par_pool_main, (void *)(intptr_t)w) != 0)
+                break;
+            pthread_detach(tid);
+            pool_nthreads = w;
+        }
+        int npool = pool_nthreads < nworkers - 1 ? pool_nthreads : nworkers - 1;
+        pool_fn = fn;
+        pool_arg = arg;
+        pool_njob = npool + 1;
+        pool_pending = npool;
+        pool_gen++;
+        pthread_cond_broadcast(&pool_wake);
+        pthread_mutex_unlock(&pool_mu);
+        /* thread creation failed: run those workers' shares inline */
+        for (int w = npool + 1; w < nworkers; w++)
+            fn(arg, w);
+        fn(arg, 0);
+        pthread_mutex_lock(&pool_mu);
+        while (pool_pending > 0)
+            pthread_cond_wait(&pool_done, &pool_mu);
+        pthread_mutex_unlock(&pool_mu);
+        pthread_mutex_unlock(&pool_busy);
+        return;
+    }
+#endif
+    for (int w = 0; w < (nworkers > 0 ? nworkers : 1); w++)
+        fn(arg, w);
+}
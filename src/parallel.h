@@ -0,0 +1,40 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ---- Fork-join worker pool ----
+ *
+ * Minimal intra-query parallelism primitive used by the plan executor.
+ * par_run() runs fn(arg, w) for w = 0..nworkers-1, worker 0 on the calling
+ * thread, and returns once every worker has finished.  Workers share no
+ * state besides arg — callers hand out work with par_claim().  The
+ * threads behind workers 1.. are a persistent pool started on first use;
+ * a par_run nested inside a running task executes its workers serially.
+ *
+ * The server is single-threaded; only plan operators that read immutable
+ * table storage and write into per-worker scratch may run inside par_run.
+ * Under MSKQL_WASM (no threads) every call degrades to serial execution. */
+
+typedef void (*par_task_fn)(void *arg, int worker);
+
+/* Number of workers to use for a parallel operator.  Reads MSKQL_THREADS
+ * once (0 or unset = number of online CPUs), clamped to [1, PAR_MAX_WORKERS]. */
+#define PAR_MAX_WORKERS 64
+int par_nworkers(void);
+
+/* Run fn on nworkers threads (including the caller) and wait for all. */
+void par_run(int nworkers, par_task_fn fn, void *arg);
+
+/* Atomically claim the next work item index from *counter. */
+static inline uint32_t par_claim(uint32_t *counter)
+{
+#ifdef MSKQL_WASM
+    return (*counter)++;
+#else
+    return __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+#endif
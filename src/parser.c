@@ -561,6 +561,8 @@ static enum win_func win_from_keyword(sv word)
     if (sv_eq_ignorecase_cstr(word, "SUM"))         return WIN_SUM;
     if (sv_eq_ignorecase_cstr(word, "COUNT"))       return WIN_COUNT;
     if (sv_eq_ignorecase_cstr(word, "AVG"))         return WIN_AVG;
+    if (sv_eq_ignorecase_cstr(word, "MIN"))         return WIN_MIN;
+    if (sv_eq_ignorecase_cstr(word, "MAX"))         return WIN_MAX;
     return WIN_ROW_NUMBER;
 }
 
@@ -1308,8 +1310,10 @@ static uint32_t parse_case_expr(struct lexer *l, struct query_arena *a)
     struct token peek = lexer_peek(l);
     int is_simple = 0;
     if (!(peek.type == TOK_KEYWORD && sv_eq_ignorecase_cstr(peek.value, "WHEN"))) {
-        /* simple CASE — parse the operand expression */
-        EXPR(a, ei).case_when.operand = parse_expr(l, a);
+        /* simple CASE — parse the operand expression (before indexing
+         * EXPR(a, ei): parsing may grow a->exprs and move it) */
+        uint32_t operand_idx = parse_expr(l, a);
+        EXPR(a, ei).case_when.operand = operand_idx;
         is_simple = 1;
     }
 
@@ -1370,7 +1374,8 @@ static uint32_t parse_case_expr(struct lexer *l, struct query_arena *a)
             }
         } else if (tok.type == TOK_KEYWORD && sv_eq_ignorecase_cstr(tok.value, "ELSE")) {
             lexer_next(l); /* consume ELSE */
-            EXPR(a, ei).case_when.else_expr = parse_expr(l, a);
+            uint32_t else_idx = parse_expr(l, a);
+            EXPR(a, ei).case_when.else_expr = else_idx;
         } else if (tok.type == TOK_KEYWORD && sv_eq_ignorecase_cstr(tok.value, "END")) {
             lexer_next(l); /* consume END */
             break;
@@ -3318,7 +3323,43 @@ parse_operator:
         struct token peek_dot = lexer_peek(l);
         if (peek_dot.type == TOK_DOT || tok.type == TOK_IDENTIFIER) {
             /* store as RHS column reference for column-to-column comparison */
+            size_t rhs_start = (size_t)(tok.value.data - l->input);
             COND(a, ci).rhs_column = consume_identifier(l, tok);
+            struct token rhs_op = lexer_peek(l);
+            if (rhs_op.type != TOK_PLUS && rhs_op.type != TOK_MINUS &&
+                rhs_op.type != TOK_STAR && rhs_op.type != TOK_SLASH &&
+                rhs_op.type != TOK_PERCENT && rhs_op.type != TOK_PIPE_PIPE &&
+                rhs_op.type != TOK_DOUBLE_COLON)
+                return ci;
+            /* arithmetic after the column (e.g. a = b + 1): parse the whole
+             * RHS and evaluate (lhs op rhs) as a boolean expression, the
+             * same shape as a bare boolean column (expr = TRUE) */
+            if (COND(a, ci).op > CMP_GE) {
+                arena_set_error(a, "0A000",
+                    "unsupported expression on the right-hand side of a comparison");
+                return IDX_NONE;
+            }
+            l->pos = rhs_start;
+            uint32_t rhs_expr = parse_expr_concat(l, a);
+            uint32_t lhs_expr = COND(a, ci).lhs_expr;
+            if (COND(a, ci).column.len > 0) {
+                struct lexer ll = { l->input, (size_t)(COND(a, ci).column.data - l->input) };
+                lhs_expr = parse_expr_concat(&ll, a);
+            }
+            uint32_t bin = expr_alloc(a, EXPR_BINARY_OP);
+            EXPR(a, bin).binary.op = COND(a, ci).op == CMP_GT ? OP_GT :
+                                     COND(a, ci).op == CMP_LT ? OP_LT :
+                                     COND(a, ci).op == CMP_GE ? OP_GE :
+                                     COND(a, ci).op == CMP_LE ? OP_LE :
+                                     COND(a, ci).op == CMP_NE ? OP_NE : OP_EQ;
+            EXPR(a, bin).binary.left = lhs_expr;
+            EXPR(a, bin).binary.right = rhs_expr;
+            COND(a, ci).lhs_expr = bin;
+            COND(a, ci).column = sv_from(NULL, 0);
+            COND(a, ci).rhs_column = sv_from(NULL, 0);
+            COND(a, ci).op = CMP_EQ;
+            COND(a, ci).value.type = COLUMN_TYPE_BOOLEAN;
+            COND(a, ci).value.value.as_bool = 1;
             return ci;
         }
     }
@@ -6922,6 +6963,7 @@ static int parse_alter(struct lexer *l, struct query *out)
                     else if (ct.type == TOK_RPAREN) { if (depth <= 0) break; depth--; }
                 }
                 out->query_type = QUERY_TYPE_SET;
+                memset(&out->set, 0, sizeof(out->set));
                 return 0;
             }
         }
@@ -7456,12 +7498,32 @@ static int query_parse_internal(const char *sql, struct query *out)
         while (lexer_next(&l).type != TOK_EOF) {}
         return 0;
     }
-    /* SET ... / RESET ... / DISCARD ... — silently accept as no-op */
+    /* SET [SESSION|LOCAL] name {=|TO} value / RESET name — the parameter and
+     * first value token are recorded for db_exec_set.  DISCARD and
+     * DEALLOCATE are silently accepted as no-ops. */
     if (sv_eq_ignorecase_cstr(tok.value, "SET") ||
         sv_eq_ignorecase_cstr(tok.value, "RESET") ||
         sv_eq_ignorecase_cstr(tok.value, "DISCARD") ||
         sv_eq_ignorecase_cstr(tok.value, "DEALLOCATE")) {
         out->query_type = QUERY_TYPE_SET;
+        int is_set = sv_eq_ignorecase_cstr(tok.value, "SET");
+        if (is_set || sv_eq_ignorecase_cstr(tok.value, "RESET")) {
+            struct token pt = lexer_next(&l);
+            if (is_set && (sv_eq_ignorecase_cstr(pt.value, "SESSION") ||
+                           sv_eq_ignorecase_cstr(pt.value, "LOCAL")))
+                pt = lexer_next(&l);
+            if (pt.type == TOK_IDENTIFIER || pt.type == TOK_KEYWORD) {
+                out->set.parameter = pt.value;
+                if (is_set) {
+                    struct token vt = lexer_next(&l);
+                    if (vt.type == TOK_EQUALS || sv_eq_ignorecase_cstr(vt.value, "TO"))
+                        vt = lexer_next(&l);
+                    if (vt.type == TOK_STRING || vt.type == TOK_NUMBER ||
+                        vt.type == TOK_IDENTIFIER || vt.type == TOK_KEYWORD)
+                        out->set.value = vt.value;
+                }
+            }
+        }
         /* consume all remaining tokens */
         while (lexer_next(&l).type != TOK_EOF) {}
         return 0;
@@ -615,10 +615,11 @@ static void client_free(struct client_state *c)
     query_arena_destroy(&c->arena);
 }
 
-/* rollback any open transaction when a client disconnects, then free */
+/* rollback any open transaction (every nesting level: tables must not keep
+ * pointing at its undo logs) when a client disconnects, then free */
 static void client_disconnect(struct client_state *c, struct database *db)
 {
-    if (c->txn.in_transaction) {
+    while (c->txn.in_transaction) {
         db->active_txn = &c->txn;
         struct query q = {0};
         q.query_type = QUERY_TYPE_ROLLBACK;
@@ -810,6 +811,8 @@ static int send_row_description(int fd, struct database *db, struct query *q,
                     case WIN_SUM:          colname = "sum";          break;
                     case WIN_COUNT:        colname = "count";        break;
                     case WIN_AVG:          colname = "avg";          break;
+                    case WIN_MIN:          colname = "min";          break;
+                    case WIN_MAX:          colname = "max";          break;
                 }
                 if (result->count > 0)
                     type_oid = column_type_to_oid(result->data[0].cells.items[i].type);
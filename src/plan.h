@@ -5,6 +5,8 @@
 #include "block.h"
 #include "table.h"
 #include "database.h"
+#include "expr_vm.h"
+#include "spill.h"
 
 /* ---- Plan node types ---- */
 
@@ -32,6 +34,8 @@ enum plan_op {
     PLAN_SUBQUERY,       /* inline subquery / CTE — streams rows from a sub-plan */
     PLAN_DISTINCT_ON,    /* keep first row per key group (DISTINCT ON desugaring) */
     PLAN_LEGACY_EXEC,    /* materialise via legacy row-at-a-time executor, stream as blocks */
+    PLAN_GATHER,         /* run scan→filter→project pipeline over morsels on worker threads */
+    PLAN_MERGE_JOIN,     /* stream-merge two inputs ordered on the join key */
 };
 
 /* ---- Plan builder result ---- */
@@ -114,7 +118,7 @@ enum vec_op_kind {
     VEC_FUNC_DATE_TRUNC,      /* DATE_TRUNC(field, date/timestamp col) → TIMESTAMP */
     VEC_FUNC_CAST_TO_TEXT,    /* CAST(numeric/date col AS TEXT) → TEXT */
     VEC_FUNC_CAST_TEXT_TO_NUM,/* CAST(text col AS INT/BIGINT/FLOAT) → numeric */
-    VEC_FUNC_CASE_WHEN,       /* CASE WHEN ... END (per-row condition eval, literal results) */
+    VEC_FUNC_CASE_WHEN,       /* CASE WHEN ... END (bytecode when compiled, else per-row) */
 };
 
 struct vec_project_op {
@@ -133,6 +137,32 @@ struct vec_project_op {
     uint32_t    lit_text2_len; /* strlen of lit_text2 */
     uint32_t    case_expr_idx; /* for VEC_FUNC_CASE_WHEN: original expr index */
     struct table *case_table;  /* for VEC_FUNC_CASE_WHEN: table for eval_expr_col */
+    struct evm_prog *case_prog; /* for VEC_FUNC_CASE_WHEN: compiled CASE, or NULL */
+};
+
+/* Block-skipping test for a seq scan, taken from a filter directly above
+ * it (see plan_exec_init): only rows whose table column col satisfies
+ * op (CMP_EQ..CMP_GE, CMP_BETWEEN, CMP_IS_[NOT_]NULL) against lo / hi can
+ * pass, so a zone of t->flat that rules that out is skipped whole. */
+struct zone_pred {
+    uint16_t            col;
+    int                 op;
+    union flat_zone_val lo, hi;
+};
+
+/* Runtime join filter: published on the scan feeding a hash join's probe
+ * side once the build is complete (see hash_join_publish_rtf).  A probe
+ * row whose key misses the Bloom filter, or falls outside [min, max] for
+ * integer keys, cannot find a match and is dropped at the scan. */
+struct join_rtf {
+    struct join_rtf  *next;       /* further filters on the same scan */
+    uint16_t          col;        /* scan output column holding the probe key */
+    enum column_type  key_type;   /* build key type */
+    int               empty;      /* build side has no non-NULL keys */
+    int               has_range;  /* min / max are valid */
+    int64_t           min, max;
+    uint64_t         *bloom;      /* [bloom_mask + 1] one 64-bit block per hash */
+    uint32_t          bloom_mask;
 };
 
 /* Plan node: arena-allocated in query_arena.plan_nodes DA.
@@ -148,13 +178,20 @@ struct plan_node {
             struct table *table;
             uint16_t     ncols;      /* number of columns to scan */
             int         *col_map;    /* bump-allocated: col_map[i] = table column index for output col i */
+            struct zone_pred *zone_preds; /* ANDed block-skipping tests, or NULL */
+            uint16_t     nzone_preds;
+            struct join_rtf *rtf;     /* runtime join filters, set during execution */
         } seq_scan;
         struct {
             struct table *table;
             struct index *idx;
             uint32_t     cond_idx;   /* condition index in arena (single-col compat) */
-            uint32_t     cond_indices[MAX_INDEX_COLS]; /* one cond_idx per index column */
-            int          nkeys;      /* number of index columns matched */
+            uint32_t     cond_indices[MAX_INDEX_COLS]; /* equality cond per leading index column */
+            int          nkeys;      /* leading index columns fixed by equality */
+            uint32_t     lo_cond;    /* >, >= or BETWEEN on index column nkeys, or IDX_NONE */
+            uint32_t     hi_cond;    /* <, <= or BETWEEN on index column nkeys, or IDX_NONE */
+            int          desc;       /* walk the index backwards (ORDER BY ... DESC) */
+            uint16_t     block_rows; /* rows per output block, 0 = BLOCK_CAPACITY */
             uint16_t     ncols;
             int         *col_map;
         } index_scan;
@@ -169,6 +206,7 @@ struct plan_node {
             uint32_t    in_count;      /* number of values in in_values */
             const char *like_pattern;  /* bump-allocated pattern for CMP_LIKE/CMP_ILIKE */
             char        like_escape;   /* custom ESCAPE char for CMP_LIKE, 0 = default '\\' */
+            struct evm_prog *vm_prog;  /* compiled predicate for complex WHERE (col_idx -1), or NULL */
         } filter;
         struct {
             uint16_t ncols;          /* number of output columns */
@@ -179,7 +217,17 @@ struct plan_node {
             int outer_key_col;       /* join key column index in outer (left child) */
             enum join_type join_type;
             enum column_type key_type; /* canonical type for hash/eq (BIGINT when int widening needed) */
+            /* composite keys (nkeys > 1): bump-allocated [nkeys] key columns,
+             * element 0 repeating inner/outer_key_col; nkeys 0 or 1 = single key */
+            uint16_t nkeys;
+            int     *inner_key_cols;
+            int     *outer_key_cols;
         } hash_join;
+        struct {
+            int inner_key_col;       /* join key column index in inner (right child) */
+            int outer_key_col;       /* join key column index in outer (left child) */
+            enum join_type join_type;
+        } merge_join;
         struct {
             uint32_t cond_idx;       /* join condition (IDX_NONE for CROSS JOIN) */
             enum join_type join_type;
@@ -209,6 +257,8 @@ struct plan_node {
             int       skip_minmax;  /* 1 = no MIN/MAX aggregates → skip min/max tracking in int fast path */
             int      *agg_order_col; /* bump: ORDER BY column index per aggregate (-1 = none) */
             int      *agg_order_desc; /* bump: 1=DESC per aggregate */
+            uint32_t  par_scan_node; /* seq scan under the child pipeline (parallel mode) */
+            uint16_t  par_nworkers;  /* >= 2 = partitioned parallel aggregation (int fast path) */
         } hash_agg;
         struct {
             uint32_t agg_start;
@@ -253,6 +303,7 @@ struct plan_node {
             struct table *table;      /* foreign table (kind == TABLE_PARQUET) */
             uint16_t     ncols;       /* number of columns to read */
             int         *col_map;     /* bump-allocated: col_map[i] = parquet column index */
+            struct join_rtf *rtf;     /* runtime join filters, set during execution */
         } parquet_scan;
         struct {
             uint16_t ncols;           /* number of output columns */
@@ -322,18 +373,52 @@ struct plan_node {
             int      sort_ord_col;    /* global order col for sort (-1 = none) */
             int      sort_ord_desc;   /* global order direction */
         } window;
+        struct {
+            uint32_t scan_node;       /* PLAN_SEQ_SCAN at the bottom of the left pipeline */
+            uint16_t nworkers;        /* worker threads (including the caller) */
+        } gather;
     };
 };
 
 /* ---- Per-node execution state ---- */
 
+/* Per-executor runtime join filter counters: a scan stops applying its
+ * filters once they have kept nearly every row they tested. */
+struct rtf_stats {
+    uint64_t seen;
+    uint64_t kept;
+    int      off;
+};
+
 struct scan_state {
     size_t cursor;   /* next row index in table */
+    size_t end;      /* stop before this row (0 = table end); set for morsels */
+    struct rtf_stats rtf;
+};
+
+/* Index scan: the row ids of one B-tree entry may span several output
+ * blocks, so the scan resumes at (ids, pos) before advancing the cursor. */
+struct index_scan_state {
+    struct index_cursor cur;
+    const size_t       *ids;     /* row ids of the current entry */
+    size_t              nids;
+    size_t              pos;     /* next id in ids */
 };
 
 struct filter_state {
-    /* stateless — operates on input block */
-    int dummy;
+    struct evm_state *vm;   /* registers for filter.vm_prog (per executor) */
+    const struct flat_dict *dict;  /* dictionary dict_match was decided for */
+    uint8_t          *dict_match;  /* [dict_nmatch] 1 = code passes the filter */
+    uint32_t          dict_nmatch;
+};
+
+struct expr_project_state {
+    struct evm_state **vm;  /* per output column: bytecode program state, or
+                             * NULL when the column is evaluated row-at-a-time */
+};
+
+struct vec_project_state {
+    struct evm_state **vm;  /* per op: state for a compiled VEC_FUNC_CASE_WHEN */
 };
 
 struct parquet_scan_state {
@@ -341,6 +426,7 @@ struct parquet_scan_state {
     /* cache-read state */
     size_t cache_cursor;  /* next row in pq_cache */
     int    using_cache;   /* 1 = serving from pq_cache */
+    struct rtf_stats rtf;
 };
 
 /* Flat column storage for hash join build side — no BLOCK_CAPACITY limit.
@@ -351,6 +437,37 @@ struct flat_col {
     uint8_t         *nulls;     /* bump: [cap] */
     void            *data;      /* bump: int32_t[cap] / int64_t[cap] / double[cap] / char*[cap] */
     uint32_t        *str_lens;  /* bump: [cap], TEXT only — strlen of each entry, or NULL */
+    uint64_t        *str_pfx;   /* bump: [cap], TEXT only — str_pfx() of each entry, or NULL */
+};
+
+/* ---- Spilling to disk (see spill.h) ----
+ * A hash join, hash aggregate or hash semi join whose state would outgrow
+ * work_mem hash-partitions its input into SPILL_FANOUT temporary files and
+ * then runs one pass per partition, with all pass state in mem.  A
+ * partition that is still too large is split again on the next hash bits. */
+struct spill_part {
+    struct spill_file rows;    /* build rows (joins) or input rows (aggregate) */
+    struct spill_file probe;   /* probe rows (joins) */
+    uint32_t          level;   /* spill_partition() level the rows were split at */
+};
+
+struct spill_state {
+    struct spill_part *pending;      /* heap: stack of partitions still to run */
+    uint32_t           npending;
+    uint32_t           pending_cap;
+    struct spill_part  cur;          /* partition of the current pass */
+    int                in_pass;      /* input comes from cur, not the child plans */
+    int                done;         /* every partition has been run */
+    int                disabled;     /* no temp files available: stay in memory */
+    struct spill_part  out[SPILL_FANOUT]; /* partitions being written */
+    uint32_t           out_level;
+    int                writing;
+    enum column_type  *types;        /* heap: [ncols] layout of rows files */
+    enum column_type  *probe_types;  /* heap: [probe_ncols] layout of probe files */
+    uint16_t           ncols;
+    uint16_t           probe_ncols;
+    struct bump_alloc  mem;          /* pass state, reset between passes */
+    struct bump_mark   probe_mark;   /* mem position to rewind to per probe block */
 };
 
 struct hash_join_state {
@@ -367,6 +484,53 @@ struct hash_join_state {
     uint8_t          *matched;       /* bitmap: matched[i]=1 if inner row i was matched (RIGHT/FULL) */
     int               outer_done;    /* 1 when probe phase is complete */
     uint32_t          right_emit_cursor; /* cursor for emitting unmatched inner rows */
+    /* probe resume: an outer block whose matches overflow one output
+     * block is kept and continued at (probe_row, probe_entry) */
+    struct row_block  probe_block;
+    int               probe_pending;
+    uint16_t          probe_row;
+    uint32_t          probe_entry;   /* chain entry to resume at, or IDX_NONE */
+    uint32_t          probe_hashes[BLOCK_CAPACITY]; /* key hash per probe_block row */
+    uint32_t          probe_heads[BLOCK_CAPACITY];  /* chain head per probe_block row */
+    const uint8_t    *probe_nulls;   /* per probe_block row: some key column is NULL */
+    uint8_t           probe_null_buf[BLOCK_CAPACITY]; /* backs probe_nulls for composite keys */
+    /* radix-partitioned build: partition p owns build rows
+     * [part_start[p], part_start[p+1]) and chains them through its own
+     * bucket range ht.buckets[part_boff[p] .. part_boff[p] + part_bmask[p]] */
+    uint32_t          nparts;        /* 0 = single unpartitioned table */
+    uint32_t          part_shift;    /* partition = hash >> part_shift */
+    uint32_t         *part_start;    /* [nparts + 1] */
+    uint32_t         *part_boff;     /* [nparts] */
+    uint32_t         *part_bmask;    /* [nparts] */
+    /* Grace partitioning once the build side outgrows work_mem, else NULL */
+    struct spill_state *spill;
+};
+
+/* Merge join state.  Both inputs arrive ascending on the key (NULLs
+ * anywhere); the inner side is consumed one key group (run) at a time into
+ * run_cols, so memory is bounded by the longest duplicate run plus the
+ * runs one output block touches. */
+struct merge_join_state {
+    struct row_block  outer;         /* current outer block */
+    enum column_type *outer_types;   /* [outer ncols] from the first outer block */
+    uint16_t          outer_pos;     /* next active position in outer */
+    int               outer_valid;
+    int               outer_done;
+    struct row_block  inner;         /* current inner block */
+    uint16_t          inner_pos;
+    int               inner_valid;
+    int               inner_done;
+    /* buffered inner rows; the current run is [run_lo, run_hi) */
+    struct flat_col  *run_cols;
+    uint16_t          inner_ncols;
+    uint32_t          run_cap;
+    uint32_t          run_lo, run_hi;
+    int               has_run;
+    int               run_null;      /* run is a single NULL-key row */
+    int               run_matched;   /* some outer row matched the run */
+    int64_t           run_key;
+    uint32_t          run_emit;      /* resume offset within the run */
+    int               finished;
 };
 
 /* Nested-loop join state — materializes both sides, emits cross product */
@@ -448,9 +612,43 @@ struct hash_agg_state {
     uint32_t  group_cap;
     int       input_done;
     uint32_t  emit_cursor;
+    /* rows of groups that did not fit in work_mem, else NULL */
+    struct spill_state *spill;
+};
+
+struct block_sort_ctx;
+
+/* One sorted run of an external sort, and its read cursor while merging */
+struct sort_run {
+    struct spill_file file;
+    struct row_block  blk;       /* rows read back from file */
+    uint16_t          pos;       /* next row of blk */
+    struct bump_alloc mem;       /* blk and its strings */
+    struct bump_mark  blk_mark;  /* mem position after blk itself */
+};
+
+/* External merge sort (sort_spill_* in plan.c): batches of input that
+ * would outgrow work_mem are sorted and written out as runs, then merged
+ * back through a heap of run cursors. */
+struct sort_spill {
+    struct sort_run  *runs;          /* heap: [nruns] in input order */
+    uint32_t          nruns;
+    uint32_t          run_cap;
+    uint32_t         *heap;          /* heap: run indices, smallest current row first */
+    uint32_t          nheap;
+    enum column_type *types;         /* heap: [ncols] layout of run files */
+    uint16_t          ncols;
+    const int        *key_cols;      /* sort keys: column, DESC, NULLS FIRST (-1 = default) */
+    const int        *key_descs;
+    const int        *key_nulls_first;
+    uint16_t          nkeys;
+    int               disabled;      /* no temp files available: stay in memory */
+    int               failed;        /* a run could not be written or read */
+    struct bump_alloc mem;           /* input batch, reset after each run */
 };
 
 struct sort_state {
+    struct block_sort_ctx *sort_ctx; /* comparator + emit context (plan.c) */
     struct row_block *collected; /* bump-allocated array of blocks */
     uint32_t nblocks;
     uint32_t block_cap;
@@ -460,6 +658,9 @@ struct sort_state {
     /* merged result */
     uint32_t *sorted_indices;   /* bump-allocated */
     uint32_t  sorted_count;
+    /* external sort once the input outgrows work_mem, else NULL */
+    struct sort_spill *spill;
+    size_t    batch_bytes;      /* estimated size of the collected batch */
 };
 
 struct window_state {
@@ -485,6 +686,9 @@ struct window_state {
     int      *win_is_i64;       /* bump: [n_win] — 1 if result is int64 */
     char    **win_str;          /* bump: [n_win * total_rows] — text results */
     int      *win_is_str;       /* bump: [n_win] — 1 if result is text */
+    /* input sorted externally by (partition, order) once it outgrows
+     * work_mem; the state above then holds one partition at a time */
+    struct sort_spill *spill;
 };
 
 struct hash_semi_join_state {
@@ -496,6 +700,9 @@ struct hash_semi_join_state {
     uint32_t               build_count;
     uint32_t               build_cap;
     int                    build_done;
+    struct row_block       probe_block;  /* outer block, allocated once */
+    /* Grace partitioning once the keys outgrow work_mem, else NULL */
+    struct spill_state    *spill;
 };
 
 struct set_op_state {
@@ -558,6 +765,32 @@ struct legacy_exec_state {
     int         done;
 };
 
+/* One morsel's pipeline output: blocks produced by a worker, emitted in
+ * morsel order so results match the serial plan exactly. */
+struct gather_morsel {
+    struct row_block *blocks;   /* worker-scratch array of output blocks */
+    uint32_t          nblocks;
+    uint32_t          cap;
+    char              errmsg[256];
+    char              sqlstate[6];
+};
+
+struct gather_state {
+    size_t                nrows;       /* table rows at first call (snapshot) */
+    uint32_t              nmorsels;    /* total morsels over nrows */
+    uint32_t              wave_start;  /* first morsel of the current wave */
+    uint32_t              wave_end;    /* one past the last morsel of the wave */
+    uint32_t              next_claim;  /* atomic: next morsel to claim in the wave */
+    uint32_t              emit_morsel; /* morsel currently being emitted */
+    uint32_t              emit_block;  /* next block within emit_morsel */
+    struct gather_morsel *morsels;     /* [wave size] per-morsel outputs */
+    struct query_arena   *worker_arenas; /* [nworkers] shallow arena copies with own scratch */
+    struct plan_exec_ctx *parent;
+    uint32_t              node_idx;
+    int                   done;
+    int                   serial;      /* a pipeline join spilled: run the child serially */
+};
+
 /* Execution context: holds arena, database, and per-node state. */
 struct plan_exec_ctx {
     struct query_arena *arena;
@@ -612,6 +845,33 @@ uint16_t plan_node_ncols(struct query_arena *arena, uint32_t node_idx);
 /* Generate EXPLAIN text for a plan tree. Writes into buf, returns bytes written. */
 int plan_explain(struct query_arena *arena, uint32_t node_idx, char *buf, int buflen);
 
+/* ---- Vectorized UPDATE / DELETE ---- */
+
+/* Block plan for a DML statement over one table: scan is the PLAN_SEQ_SCAN,
+ * filter the top of the WHERE chain (the scan itself without a WHERE) and
+ * project a PLAN_VEC_PROJECT computing the SET expressions, or IDX_NONE
+ * for a DELETE. */
+struct dml_plan {
+    uint32_t scan;
+    uint32_t filter;
+    uint32_t project;
+};
+
+/* Build a dml_plan for t.  where_cond may be IDX_NONE (every row);
+ * set_exprs[0..nset-1] are the SET expression indices (nset 0 for DELETE).
+ * Returns 0, or -1 when the WHERE or a SET expression has no block form
+ * and the caller must evaluate row by row. */
+int plan_build_dml(struct table *t, uint32_t where_cond, const uint32_t *set_exprs,
+                   uint16_t nset, struct query_arena *arena, struct dml_plan *dp);
+
+/* Pull the next batch of qualifying rows: their t->flat row ids go to
+ * row_ids[0..n-1] (room for BLOCK_CAPACITY) and, with a project, the SET
+ * values to vals (nset columns, row i belongs to row_ids[i]; no value
+ * points into t->flat's fixed-width storage).  Returns n > 0, 0 at end of
+ * data, or -1 on error with the arena's error set. */
+int plan_dml_next(struct plan_exec_ctx *ctx, const struct dml_plan *dp,
+                  size_t *row_ids, struct row_block *vals);
+
 /* ---- Block utility functions ---- */
 
 /* Initialize a row_block with ncols columns, bump-allocated from scratch. */
@@ -5475,17 +5475,26 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
 
                 case WIN_SUM:
                 case WIN_COUNT:
-                case WIN_AVG: {
+                case WIN_AVG:
+                case WIN_MIN:
+                case WIN_MAX: {
+                    int want_min = (se->win.func == WIN_MIN);
+                    int arg_is_flt = (arg_idx[e] >= 0 &&
+                                      t->columns.items[arg_idx[e]].type == COLUMN_TYPE_FLOAT);
                     if (!se->win.has_frame && !se->win.has_order) {
                         /* no frame, no ORDER BY: compute partition total in one pass */
                         double part_sum = 0.0;
+                        double part_ext = 0.0; /* MIN/MAX */
                         int part_nn = 0;
                         int part_count = (int)psize;
                         for (size_t i = ps; i < pe; i++) {
                             if (arg_idx[e] >= 0) {
                                 struct cell _wsc = flat_cell_at(&t->flat, (uint16_t)arg_idx[e], sorted_idx[i]);
                                 if (!_wsc.is_null && !(column_type_is_text(_wsc.type) && !_wsc.value.as_text)) {
-                                    part_sum += cell_to_double(&_wsc);
+                                    double v = cell_to_double(&_wsc);
+                                    if (!part_nn || (want_min ? v < part_ext : v > part_ext))
+                                        part_ext = v;
+                                    part_sum += v;
                                     part_nn++;
                                 }
                             }
@@ -5502,19 +5511,27 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                                 }
                             } else if (se->win.func == WIN_COUNT) {
                                 win_int_vals[oi * nexprs + e] = (arg_idx[e] >= 0) ? part_nn : part_count;
-                            } else { /* WIN_AVG */
+                            } else if (se->win.func == WIN_AVG) {
                                 win_is_dbl[e] = 1;
                                 if (part_nn > 0) {
                                     win_dbl_vals[oi * nexprs + e] = part_sum / (double)part_nn;
                                 } else {
                                     win_is_null[oi * nexprs + e] = 1;
                                 }
+                            } else if (part_nn == 0) { /* WIN_MIN / WIN_MAX */
+                                win_is_null[oi * nexprs + e] = 1;
+                            } else if (arg_is_flt) {
+                                win_is_dbl[e] = 1;
+                                win_dbl_vals[oi * nexprs + e] = part_ext;
+                            } else {
+                                win_int_vals[oi * nexprs + e] = (int)part_ext;
                             }
                         }
                     } else if (!se->win.has_frame && se->win.has_order) {
                         /* ORDER BY without explicit frame: implicit UNBOUNDED PRECEDING TO CURRENT ROW
                          * — compute cumulative running values */
                         double running_sum = 0.0;
+                        double running_ext = 0.0; /* MIN/MAX */
                         int running_nn = 0;
                         int running_count = 0;
                         int running_any = 0; /* 1 if any row passed FILTER so far */
@@ -5531,7 +5548,10 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                                 if (arg_idx[e] >= 0) {
                                     struct cell _wrc = flat_cell_at(&t->flat, (uint16_t)arg_idx[e], sorted_idx[i]);
                                     if (!_wrc.is_null && !(column_type_is_text(_wrc.type) && !_wrc.value.as_text)) {
-                                        running_sum += cell_to_double(&_wrc);
+                                        double v = cell_to_double(&_wrc);
+                                        if (!running_nn || (want_min ? v < running_ext : v > running_ext))
+                                            running_ext = v;
+                                        running_sum += v;
                                         running_nn++;
                                     }
                                 }
@@ -5553,13 +5573,20 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                                 }
                             } else if (se->win.func == WIN_COUNT) {
                                 win_int_vals[oi * nexprs + e] = (arg_idx[e] >= 0) ? running_nn : running_count;
-                            } else { /* WIN_AVG */
+                            } else if (se->win.func == WIN_AVG) {
                                 win_is_dbl[e] = 1;
                                 if (running_nn > 0) {
                                     win_dbl_vals[oi * nexprs + e] = running_sum / (double)running_nn;
                                 } else {
                                     win_is_null[oi * nexprs + e] = 1;
                                 }
+                            } else if (running_nn == 0) { /* WIN_MIN / WIN_MAX */
+                                win_is_null[oi * nexprs + e] = 1;
+                            } else if (arg_is_flt) {
+                                win_is_dbl[e] = 1;
+                                win_dbl_vals[oi * nexprs + e] = running_ext;
+                            } else {
+                                win_int_vals[oi * nexprs + e] = (int)running_ext;
                             }
                         }
                     } else {
@@ -5634,6 +5661,7 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                             }
 
                             double frame_sum = 0.0;
+                            double frame_ext = 0.0; /* MIN/MAX */
                             int frame_nn = 0;
                             int frame_count = 0;
                             for (size_t fi = fs; fi < fe; fi++) {
@@ -5654,7 +5682,10 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                                 if (arg_idx[e] >= 0) {
                                     struct cell _wfc = flat_cell_at(&t->flat, (uint16_t)arg_idx[e], j);
                                     if (!_wfc.is_null && !(column_type_is_text(_wfc.type) && !_wfc.value.as_text)) {
-                                        frame_sum += cell_to_double(&_wfc);
+                                        double v = cell_to_double(&_wfc);
+                                        if (!frame_nn || (want_min ? v < frame_ext : v > frame_ext))
+                                            frame_ext = v;
+                                        frame_sum += v;
                                         frame_nn++;
                                     }
                                 }
@@ -5670,13 +5701,20 @@ static int query_window(struct table *t, struct query_select *s, struct query_ar
                                 }
                             } else if (se->win.func == WIN_COUNT) {
                                 win_int_vals[oi * nexprs + e] = (arg_idx[e] >= 0) ? frame_nn : frame_count;
-                            } else { /* WIN_AVG */
+                            } else if (se->win.func == WIN_AVG) {
                                 win_is_dbl[e] = 1;
                                 if (frame_nn > 0) {
                                     win_dbl_vals[oi * nexprs + e] = frame_sum / (double)frame_nn;
                                 } else {
                                     win_is_null[oi * nexprs + e] = 1;
                                 }
+                            } else if (frame_nn == 0) { /* WIN_MIN / WIN_MAX */
+                                win_is_null[oi * nexprs + e] = 1;
+                            } else if (arg_is_flt) {
+                                win_is_dbl[e] = 1;
+                                win_dbl_vals[oi * nexprs + e] = frame_ext;
+                            } else {
+                                win_int_vals[oi * nexprs + e] = (int)frame_ext;
                             }
                         }
                     }
@@ -7366,41 +7404,6 @@ int query_select_exec(struct table *t, struct query_select *s, struct query_aren
     return 0;
 }
 
-static void rebuild_indexes(struct table *t)
-{
-    for (size_t idx = 0; idx < t->indexes.count; idx++) {
-        struct index *ix = &t->indexes.items[idx];
-        index_reset(ix);
-        /* re-insert all rows */
-        for (size_t r = 0; r < t->flat.nrows; r++) {
-            switch (ix->type) {
-            case INDEX_BTREE: {
-                struct cell composite[MAX_INDEX_COLS];
-                int ok = 1;
-                for (int c = 0; c < ix->ncols; c++) {
-                    int ci = ix->column_indices[c];
-                    if (ci >= 0 && (uint16_t)ci < t->flat.ncols)
-                        composite[c] = flat_cell_at(&t->flat, (uint16_t)ci, r);
-                    else
-                        ok = 0;
-                }
-                if (ok) index_insert(ix, composite, r);
-                break;
-            }
-            case INDEX_HNSW: {
-                int ci = ix->hnsw->col_idx;
-                if (ci >= 0 && (uint16_t)ci < t->flat.ncols) {
-                    struct cell _hc = flat_cell_at(&t->flat, (uint16_t)ci, r);
-                    if (!_hc.is_null && _hc.value.as_vector)
-                        hnsw_insert(ix->hnsw, _hc.value.as_vector, r);
-                }
-                break;
-            }
-            }
-        }
-    }
-}
-
 void emit_returning_row(struct table *t, struct row *src,
                                sv returning_columns, int return_all,
                                struct rows *result, struct bump_alloc *rb)
@@ -7487,39 +7490,117 @@ static int fk_enforce_update(struct database *db, struct table *parent_t,
                               const struct cell *old_val, const struct cell *new_val,
                               const char *parent_col_name, struct query_arena *arena);
 
+/* Remove the rows a DELETE tombstoned: the target's own and any that
+ * ON DELETE CASCADE marked in child tables. */
+static void purge_deleted_rows(struct database *db)
+{
+    for (size_t ti = 0; ti < db->tables.count; ti++)
+        if (db->tables.items[ti].del_bits)
+            table_flat_purge_deleted(&db->tables.items[ti]);
+}
+
+/* 1 if a foreign key of some table in db references t. */
+static int table_is_fk_parent(struct database *db, const struct table *t)
+{
+    for (size_t ti = 0; ti < db->tables.count; ti++) {
+        struct table *ct = &db->tables.items[ti];
+        for (size_t ci = 0; ci < ct->columns.count; ci++)
+            if (ct->columns.items[ci].fk_table &&
+                strcmp(ct->columns.items[ci].fk_table, t->name) == 0)
+                return 1;
+    }
+    return 0;
+}
+
+/* Run the WHERE of a DELETE through the block executor (plan_build_dml)
+ * and collect the ids of the matching rows into a malloc'd *ids.  Returns
+ * 0, 1 when the WHERE has no block form (nothing collected), or -1 on
+ * error. */
+static int dml_collect_rows(struct table *t, struct where_clause *w, struct query_arena *arena,
+                            struct database *db, size_t **ids, size_t *nids)
+{
+    *ids = NULL;
+    *nids = 0;
+    if (!table_is_writable(t->kind) || (w->has_where && w->where_cond == IDX_NONE))
+        return 1;
+    struct dml_plan dp;
+    if (plan_build_dml(t, w->has_where ? w->where_cond : IDX_NONE, NULL, 0, arena, &dp) != 0) {
+        arena_clear_error(arena);
+        return 1;
+    }
+    struct plan_exec_ctx ctx;
+    plan_exec_init(&ctx, arena, db, dp.filter);
+    size_t cap = 0;
+    for (;;) {
+        if (*nids + BLOCK_CAPACITY > cap) {
+            cap = cap ? cap * 2 : (size_t)BLOCK_CAPACITY * 4;
+            size_t *grown = (size_t *)realloc(*ids, cap * sizeof(size_t));
+            if (!grown) { fprintf(stderr, "OOM: dml_collect_rows\n"); abort(); }
+            *ids = grown;
+        }
+        int n = plan_dml_next(&ctx, &dp, *ids + *nids, NULL);
+        if (n <= 0) {
+            plan_exec_cleanup(&ctx);
+            if (n == 0) return 0;
+            free(*ids);
+            *ids = NULL;
+            *nids = 0;
+            return -1;
+        }
+        *nids += (size_t)n;
+    }
+}
+
 static int query_delete_exec(struct table *t, struct query_delete *d, struct query_arena *arena, struct rows *result, struct database *db, struct bump_alloc *rb)
 {
     int has_ret = (d->has_returning && d->returning_columns.len > 0);
     int return_all = has_ret && sv_eq_cstr(d->returning_columns, "*");
     size_t deleted = 0;
-    for (size_t i = 0; i < t->flat.nrows; ) {
-        struct flat_row_ref _dref = flat_row_ref_make(t, i);
+    /* The matching rows are found up front by the block executor when the
+     * WHERE allows it, else row by row below.  Matches are only tombstoned
+     * here, so row ids stay put for the whole statement; the table is
+     * compacted once at the end. */
+    size_t *ids;
+    size_t nids;
+    int rc = dml_collect_rows(t, &d->where, arena, db, &ids, &nids);
+    if (rc < 0) return -1;
+    int planned = rc == 0;
+    int fk_parent = table_is_fk_parent(db, t);
+    int need_row = fk_parent || (has_ret && result);
+    size_t nscan = planned ? nids : t->flat.nrows;
+    for (size_t k = 0; k < nscan; k++) {
+        size_t i = planned ? ids[k] : k;
+        if (table_row_deleted(t, i)) continue; /* cascaded from an earlier row */
         struct row _dtmp = {0};
-        flat_row_ref_to_row(&_dref, &_dtmp, &arena->scratch);
-        if (row_matches(t, &d->where, arena, &_dtmp, NULL)) {
-            /* enforce FK constraints before deleting */
-            if (fk_enforce_delete(db, t, &_dtmp, arena) != 0)
-                return -1;
-            /* capture row for RETURNING before freeing */
-            if (has_ret && result)
-                emit_returning_row(t, &_dtmp, d->returning_columns, return_all, result, rb);
-            table_flat_delete_row(t, i);
+        if (!planned || need_row) {
+            struct flat_row_ref _dref = flat_row_ref_make(t, i);
+            flat_row_ref_to_row(&_dref, &_dtmp, &arena->scratch);
+            if (!planned && !row_matches(t, &d->where, arena, &_dtmp, NULL)) continue;
+        }
+        /* enforce FK constraints before deleting */
+        if (fk_parent && fk_enforce_delete(db, t, &_dtmp, arena) != 0) {
+            free(ids);
+            purge_deleted_rows(db);
+            return -1;
+        }
+        /* capture row for RETURNING before the row goes away */
+        if (has_ret && result)
+            emit_returning_row(t, &_dtmp, d->returning_columns, return_all, result, rb);
+        table_flat_mark_deleted(t, i);
 #ifndef MSKQL_WASM
-            if (t->kind == TABLE_DISK) {
-                int wb = (int)disk_wal_append_delete(t->disk.dir_path, (uint64_t)i);
-                if (wb > 0) { t->disk.wal_bytes += (uint64_t)wb; t->disk.wal_dirty = 1; }
-            }
-#endif /* MSKQL_WASM */
-            deleted++;
-            t->generation++;
-            db->total_generation++;
-        } else {
-            i++;
+        if (t->kind == TABLE_DISK) {
+            /* WAL row ids count the rows already removed before this one */
+            int wb = (int)disk_wal_append_delete(t->disk.dir_path, (uint64_t)(i - deleted));
+            if (wb > 0) { t->disk.wal_bytes += (uint64_t)wb; t->disk.wal_dirty = 1; }
         }
+#endif /* MSKQL_WASM */
+        deleted++;
+        t->generation++;
+        db->total_generation++;
     }
-    /* rebuild indexes after row removal */
-    if (deleted > 0 && t->indexes.count > 0)
-        rebuild_indexes(t);
+    free(ids);
+    /* one compaction pass per table; indexes are renumbered, not rebuilt */
+    purge_deleted_rows(db);
 
     /* store deleted count for command tag (only if not RETURNING) */
     if (!has_ret && result) {
@@ -7535,6 +7616,88 @@ static int query_delete_exec(struct table *t, struct query_delete *d, struct que
 
 static int check_constraints_ok(struct table *t, struct row *row, struct query_arena *arena, struct database *db);
 
+/* Vectorized UPDATE: the WHERE and the SET expressions run through the
+ * block executor (plan_build_dml) and each batch of new values is written
+ * a column at a time with table_flat_update_col.  Only for statements
+ * without row-at-a-time side effects: no CHECK constraint, t not referenced
+ * by a foreign key, and SET targets that are not indexed, not ENUM, VECTOR
+ * or a foreign key, and get a value of exactly their type.  Returns 0 with
+ * *updated set, 1 when the statement needs the row path (nothing changed),
+ * or -1 on error. */
+static int query_update_vec(struct table *t, struct query_update *u, struct query_arena *arena,
+                            struct database *db, size_t *updated)
+{
+    uint32_t nsc = u->set_clauses_count;
+    if (nsc == 0 || nsc > t->columns.count || !table_is_writable(t->kind))
+        return 1;
+    if (u->where.has_where && u->where.where_cond == IDX_NONE) return 1;
+    for (size_t c = 0; c < t->columns.count; c++)
+        if (t->columns.items[c].check_expr_sql) return 1;
+    if (table_is_fk_parent(db, t)) return 1;
+
+    uint32_t *exprs = (uint32_t *)bump_alloc(&arena->scratch, nsc * sizeof(uint32_t));
+    uint16_t *cols = (uint16_t *)bump_alloc(&arena->scratch, nsc * sizeof(uint16_t));
+    for (uint32_t sc = 0; sc < nsc; sc++) {
+        struct set_clause *scp = &arena->set_clauses.items[u->set_clauses_start + sc];
+        int ci = table_find_column_sv(t, scp->column);
+        if (ci < 0 || scp->is_default || scp->expr_idx == IDX_NONE) return 1;
+        struct column *col = &t->columns.items[ci];
+        if (col->type == COLUMN_TYPE_ENUM || col->type == COLUMN_TYPE_VECTOR || col->fk_table)
+            return 1;
+        for (size_t ix = 0; ix < t->indexes.count; ix++)
+            for (int k = 0; k < t->indexes.items[ix].ncols; k++)
+                if (t->indexes.items[ix].column_indices[k] == ci) return 1;
+        cols[sc] = (uint16_t)ci;
+        exprs[sc] = scp->expr_idx;
+    }
+
+    struct dml_plan dp;
+    if (plan_build_dml(t, u->where.has_where ? u->where.where_cond : IDX_NONE,
+                       exprs, (uint16_t)nsc, arena, &dp) != 0) {
+        arena_clear_error(arena);
+        return 1;
+    }
+    struct plan_node *vp = &PLAN_NODE(arena, dp.project);
+    for (uint32_t sc = 0; sc < nsc; sc++)
+        if (vp->vec_project.ops[vp->vec_project.aux_count + sc].out_type !=
+            t->columns.items[cols[sc]].type)
+            return 1;
+
+    struct plan_exec_ctx ctx;
+    plan_exec_init(&ctx, arena, db, dp.project);
+    size_t row_ids[BLOCK_CAPACITY];
+    struct row_block vals;
+    row_block_alloc(&vals, (uint16_t)nsc, &arena->scratch);
+    int n;
+    while ((n = plan_dml_next(&ctx, &dp, row_ids, &vals)) > 0) {
+        for (uint32_t sc = 0; sc < nsc; sc++) {
+            struct col_block *cb = &vals.cols[sc];
+            struct column *col = &t->columns.items[cols[sc]];
+            int is_text = col->type == COLUMN_TYPE_TEXT;
+            for (int i = 0; i < n; i++) {
+                int is_null = cb->nulls[i] || (is_text && !cb->data.str[i]);
+                /* the whole batch is checked before any of it is written */
+                if (is_null && col->not_null) {
+                    arena_set_error(arena, "23502",
+                        "NOT NULL constraint violated for column '%s'", col->name);
+                    plan_exec_cleanup(&ctx);
+                    return -1;
+                }
+                /* copy strings: a passthrough value may be one this batch
+                 * replaces (SET a = b, b = a) */
+                if (is_text)
+                    cb->data.str[i] = is_null ? NULL : bump_strdup(&arena->scratch, cb->data.str[i]);
+                cb->nulls[i] = (uint8_t)is_null;
+            }
+        }
+        for (uint32_t sc = 0; sc < nsc; sc++)
+            table_flat_update_col(t, cols[sc], row_ids, &vals.cols[sc], (uint16_t)n);
+        *updated += (size_t)n;
+    }
+    plan_exec_cleanup(&ctx);
+    return n < 0 ? -1 : 0;
+}
+
 static int query_update_exec(struct table *t, struct query_update *u, struct query_arena *arena, struct rows *result, struct database *db, struct bump_alloc *rb)
 {
     int has_ret = (u->has_returning && u->returning_columns.len > 0);
@@ -7583,7 +7746,15 @@ static int query_update_exec(struct table *t, struct query_update *u, struct que
         }
     }
 
-    size_t scan_count = use_index_scan ? idx_row_count : t->flat.nrows;
+    /* a full scan runs vectorized when the statement allows it */
+    int vectorized = 0;
+    if (!use_index_scan && !has_ret) {
+        int vrc = query_update_vec(t, u, arena, db, &updated);
+        if (vrc < 0) return -1;
+        vectorized = vrc == 0;
+    }
+
+    size_t scan_count = vectorized ? 0 : use_index_scan ? idx_row_count : t->flat.nrows;
     for (size_t si = 0; si < scan_count; si++) {
         size_t i = use_index_scan ? idx_row_ids[si] : si;
         if (i >= t->flat.nrows) continue;
@@ -7640,6 +7811,30 @@ static int query_update_exec(struct table *t, struct query_update *u, struct que
                 }
             }
         }
+        /* coerce TEXT → DATE/TIME/TIMESTAMP/INTERVAL, as INSERT does */
+        for (uint32_t sc = 0; sc < nsc; sc++) {
+            if (col_idxs[sc] < 0) continue;
+            enum column_type ct = t->columns.items[col_idxs[sc]].type;
+            struct cell *nv = &new_vals[sc];
+            if (!column_type_is_temporal(ct) || nv->type != COLUMN_TYPE_TEXT ||
+                nv->is_null || !nv->value.as_text)
+                continue;
+            char *s = nv->value.as_text;
+            switch (ct) {
+            case COLUMN_TYPE_DATE:        nv->value.as_date = date_from_str(s); break;
+            case COLUMN_TYPE_TIME:        nv->value.as_time = time_from_str(s); break;
+            case COLUMN_TYPE_TIMESTAMP:
+            case COLUMN_TYPE_TIMESTAMPTZ: nv->value.as_timestamp = timestamp_from_str(s); break;
+            case COLUMN_TYPE_INTERVAL:    nv->value.as_interval = interval_from_str(s); break;
+            case COLUMN_TYPE_SMALLINT: case COLUMN_TYPE_INT: case COLUMN_TYPE_BIGINT:
+            case COLUMN_TYPE_FLOAT: case COLUMN_TYPE_NUMERIC: case COLUMN_TYPE_BOOLEAN:
+            case COLUMN_TYPE_TEXT: case COLUMN_TYPE_ENUM: case COLUMN_TYPE_UUID:
+            case COLUMN_TYPE_VECTOR:
+                __builtin_unreachable();
+            }
+            nv->type = ct;
+            free(s);
+        }
         /* enforce NOT NULL constraints on SET values */
         for (uint32_t sc = 0; sc < nsc; sc++) {
             if (col_idxs[sc] < 0) continue;
@@ -7756,7 +7951,11 @@ static int query_update_exec(struct table *t, struct query_update *u, struct que
                 da_push(&_upatch.cells, cv);
             }
             table_flat_update_row(t, i, &_upatch);
-            if (!rb) row_free(&_upatch); else da_free(&_upatch.cells);
+            /* flat now holds its own copies; the other cells are borrowed */
+            da_free(&_upatch.cells);
+            for (uint32_t sc = 0; sc < nsc; sc++)
+                if (column_type_is_text(new_vals[sc].type) && new_vals[sc].value.as_text)
+                    free(new_vals[sc].value.as_text);
         }
         /* enforce CHECK constraints on the updated row */
         { struct flat_row_ref _uchk = flat_row_ref_make(t, i); flat_row_ref_to_row(&_uchk, &_utmp, &arena->scratch); }
@@ -7843,11 +8042,15 @@ static int fk_enforce_delete(struct database *db, struct table *parent_t,
             if (parent_val->is_null) continue;
 
             enum fk_action action = col->fk_on_delete;
+            /* cascades change the child inside the same transaction */
+            if (db->active_txn && db->active_txn->in_transaction)
+                snapshot_log_table(db->active_txn->snapshot, db, child_t);
 
             /* Scan child rows for matches */
             for (size_t r = 0; r < child_t->flat.nrows; ) {
                 struct cell child_cv = flat_cell_at(&child_t->flat, (uint16_t)ci, r);
-                if (child_cv.is_null || cell_compare(parent_val, &child_cv) != 0) {
+                if (child_cv.is_null || table_row_deleted(child_t, r) ||
+                    cell_compare(parent_val, &child_cv) != 0) {
                     r++;
                     continue;
                 }
@@ -7860,10 +8063,12 @@ static int fk_enforce_delete(struct database *db, struct table *parent_t,
                             parent_t->name, child_t->name);
                         return -1;
                     case FK_CASCADE:
-                        table_flat_delete_row(child_t, r);
+                        /* removed with the parent rows when the DELETE ends */
+                        table_flat_mark_deleted(child_t, r);
                         child_t->generation++;
                         db->total_generation++;
-                        continue; /* don't increment r */
+                        r++;
+                        break;
                     case FK_SET_NULL: {
                         struct row _fkr = {0};
                         da_init(&_fkr.cells);
@@ -7925,6 +8130,8 @@ static int fk_enforce_update(struct database *db, struct table *parent_t,
                 continue;
 
             enum fk_action action = col->fk_on_update;
+            if (db->active_txn && db->active_txn->in_transaction)
+                snapshot_log_table(db->active_txn->snapshot, db, child_t);
 
             for (size_t r = 0; r < child_t->flat.nrows; r++) {
                 struct cell child_cv = flat_cell_at(&child_t->flat, (uint16_t)ci, r);
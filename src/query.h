@@ -52,7 +52,9 @@ enum win_func {
     WIN_NTH_VALUE,
     WIN_SUM,
     WIN_COUNT,
-    WIN_AVG
+    WIN_AVG,
+    WIN_MIN,
+    WIN_MAX
 };
 
 /* window frame boundary types */
@@ -878,6 +880,11 @@ struct query_show {
     sv parameter;        /* parameter name for SHOW */
 };
 
+struct query_set {
+    sv parameter;        /* parameter name for SET / RESET, empty if none */
+    sv value;            /* first value token, empty for RESET or SET ... TO DEFAULT */
+};
+
 /* Returns 1 if the query type is read-only (no database mutation). */
 static inline int query_is_read_only(enum query_type qt)
 {
@@ -939,6 +946,7 @@ struct query {
         struct query_explain explain;
         struct query_copy copy;
         struct query_show show;
+        struct query_set set;
         struct query_create_foreign_table create_foreign_table;
     };
 };
@@ -0,0 +1,256 @@
+#include "spill.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#ifndef MSKQL_WASM
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+/* ---- temporary files ---- */
+
+#ifndef MSKQL_WASM
+
+int spill_open(struct spill_file *sf)
+{
+    memset(sf, 0, sizeof(*sf));
+    sf->fd = -1;
+    const char *dir = getenv("MSKQL_DATA_DIR");
+    if (!dir || !*dir) dir = "mskql_data";
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/spill.XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    unlink(path);
+    sf->buf = (uint8_t *)malloc(SPILL_BUF_SIZE);
+    if (!sf->buf) { fprintf(stderr, "OOM: spill_open\n"); abort(); }
+    sf->fd = fd;
+    return 0;
+}
+
+static void spill_flush(struct spill_file *sf)
+{
+    uint32_t off = 0;
+    while (off < sf->pos && !sf->failed) {
+        ssize_t w = write(sf->fd, sf->buf + off, sf->pos - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { sf->failed = 1; break; }
+        off += (uint32_t)w;
+    }
+    sf->pos = 0;
+}
+
+int spill_rewind(struct spill_file *sf)
+{
+    if (sf->fd < 0) return -1;
+    spill_flush(sf);
+    if (lseek(sf->fd, 0, SEEK_SET) != 0) sf->failed = 1;
+    sf->pos = 0;
+    sf->len = 0;
+    return sf->failed ? -1 : 0;
+}
+
+void spill_close(struct spill_file *sf)
+{
+    if (sf->fd >= 0) close(sf->fd);
+    free(sf->buf);
+    sf->fd = -1;
+    sf->buf = NULL;
+    sf->pos = sf->len = 0;
+    sf->nrows = 0;
+}
+
+void spill_write(struct spill_file *sf, const void *p, size_t n)
+{
+    const uint8_t *src = (const uint8_t *)p;
+    while (n > 0) {
+        if (sf->pos == SPILL_BUF_SIZE) spill_flush(sf);
+        size_t k = SPILL_BUF_SIZE - sf->pos;
+        if (k > n) k = n;
+        memcpy(sf->buf + sf->pos, src, k);
+        sf->pos += (uint32_t)k;
+        src += k;
+        n -= k;
+    }
+}
+
+int spill_read(struct spill_file *sf, void *p, size_t n)
+{
+    uint8_t *dst = (uint8_t *)p;
+    while (n > 0) {
+        if (sf->pos == sf->len) {
+            ssize_t r = read(sf->fd, sf->buf, SPILL_BUF_SIZE);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) sf->failed = 1;
+            if (r <= 0) return -1;
+            sf->pos = 0;
+            sf->len = (uint32_t)r;
+        }
+        size_t k = sf->len - sf->pos;
+        if (k > n) k = n;
+        memcpy(dst, sf->buf + sf->pos, k);
+        sf->pos += (uint32_t)k;
+        dst += k;
+        n -= k;
+    }
+    return 0;
+}
+
+#else /* MSKQL_WASM: no filesystem, operators never spill */
+
+int spill_open(struct spill_file *sf)
+{
+    memset(sf, 0, sizeof(*sf));
+    sf->fd = -1;
+    return -1;
+}
+
+int spill_rewind(struct spill_file *sf) { (void)sf; return -1; }
+
+void spill_close(struct spill_file *sf) { sf->fd = -1; }
+
+void spill_write(struct spill_file *sf, const void *p, size_t n)
+{
+    (void)p; (void)n;
+    sf->failed = 1;
+}
+
+int spill_read(struct spill_file *sf, void *p, size_t n)
+{
+    (void)sf; (void)p; (void)n;
+    return -1;
+}
+
+#endif /* MSKQL_WASM */
+
+/* ---- value encoding ---- */
+
+void spill_write_value(struct spill_file *sf, enum column_type type,
+                       const void *v, uint16_t vec_dim)
+{
+    uint8_t is_null = v == NULL;
+    spill_write(sf, &is_null, 1);
+    if (is_null) return;
+    switch (column_type_storage(type)) {
+    case STORE_STR: {
+        const char *s = *(const char *const *)v;
+        uint32_t len = s ? (uint32_t)strlen(s) : 0;
+        spill_write(sf, &len, sizeof(len));
+        spill_write(sf, s, len);
+        return;
+    }
+    case STORE_VEC:
+        spill_write(sf, &vec_dim, sizeof(vec_dim));
+        spill_write(sf, v, (size_t)vec_dim * sizeof(float));
+        return;
+    case STORE_I16:
+    case STORE_I32:
+    case STORE_I64:
+    case STORE_F64:
+    case STORE_IV:
+    case STORE_UUID:
+        spill_write(sf, v, col_type_elem_size(type));
+        return;
+    }
+    __builtin_unreachable();
+}
+
+int spill_read_value(struct spill_file *sf, struct col_block *cb, uint16_t i,
+                     struct bump_alloc *mem)
+{
+    uint8_t is_null;
+    if (spill_read(sf, &is_null, 1) != 0) return -1;
+    cb->nulls[i] = is_null;
+    switch (column_type_storage(cb->type)) {
+    case STORE_STR: {
+        uint32_t len = 0;
+        char *s = NULL;
+        if (!is_null) {
+            if (spill_read(sf, &len, sizeof(len)) != 0) return -1;
+            s = (char *)bump_alloc(mem, len + 1);
+            if (spill_read(sf, s, len) != 0) return -1;
+            s[len] = '\0';
+        }
+        cb->data.str[i] = s;
+        if (cb->str_lens) cb->str_lens[i] = len;
+        return 0;
+    }
+    case STORE_VEC: {
+        if (is_null) return 0;
+        uint16_t dim;
+        if (spill_read(sf, &dim, sizeof(dim)) != 0) return -1;
+        if (!cb->data.vec || cb->vec_dim != dim) {
+            cb->data.vec = (float *)bump_calloc(mem, (size_t)dim * BLOCK_CAPACITY, sizeof(float));
+            cb->vec_dim = dim;
+        }
+        return spill_read(sf, &cb->data.vec[(size_t)i * dim], (size_t)dim * sizeof(float));
+    }
+    case STORE_I16:
+    case STORE_I32:
+    case STORE_I64:
+    case STORE_F64:
+    case STORE_IV:
+    case STORE_UUID: {
+        size_t esz = col_type_elem_size(cb->type);
+        if (is_null) {
+            memset(cb_data_ptr(cb, i), 0, esz);
+            return 0;
+        }
+        return spill_read(sf, cb_data_ptr(cb, i), esz);
+    }
+    }
+    __builtin_unreachable();
+}
+
+/* ---- work_mem ---- */
+
+int spill_parse_mem(const char *s, size_t len, size_t *out)
+{
+    size_t i = 0;
+    while (i < len && isspace((unsigned char)s[i])) i++;
+    if (i == len || !isdigit((unsigned char)s[i])) return -1;
+    unsigned long long n = 0;
+    while (i < len && isdigit((unsigned char)s[i])) {
+        n = n * 10 + (unsigned long long)(s[i] - '0');
+        if (n > ((unsigned long long)1 << 40)) return -1;
+        i++;
+    }
+    while (i < len && isspace((unsigned char)s[i])) i++;
+    size_t ulen = len - i;
+    const char *u = s + i;
+    while (ulen > 0 && isspace((unsigned char)u[ulen - 1])) ulen--;
+    unsigned long long mul;
+    if (ulen == 0 || (ulen == 2 && strncasecmp(u, "kB", 2) == 0)) mul = 1024ULL;
+    else if (ulen == 2 && strncasecmp(u, "MB", 2) == 0) mul = 1024ULL * 1024;
+    else if (ulen == 2 && strncasecmp(u, "GB", 2) == 0) mul = 1024ULL * 1024 * 1024;
+    else if (ulen == 2 && strncasecmp(u, "TB", 2) == 0) mul = 1024ULL * 1024 * 1024 * 1024;
+    else if (ulen == 1 && (u[0] == 'B' || u[0] == 'b')) mul = 1;
+    else return -1;
+    if (n > ((unsigned long long)SIZE_MAX / 2) / mul) return -1;
+    unsigned long long bytes = n * mul;
+    if (bytes < SPILL_MIN_WORK_MEM) return -1;
+    *out = (size_t)bytes;
+    return 0;
+}
+
+void spill_format_mem(size_t bytes, char *buf, size_t bufsz)
+{
+    static const char *units[] = { "kB", "MB", "GB", "TB" };
+    size_t v = bytes / 1024;
+    int u = 0;
+    while (u < 3 && v >= 1024 && v % 1024 == 0) { v /= 1024; u++; }
+    snprintf(buf, bufsz, "%zu%s", v, units[u]);
+}
+
+size_t spill_default_work_mem(void)
+{
+    size_t v;
+    const char *env = getenv("MSKQL_WORK_MEM");
+    if (env && *env && spill_parse_mem(env, strlen(env), &v) == 0)
+        return v;
+    return SPILL_DEFAULT_WORK_MEM;
+}
@@ -0,0 +1,82 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "block.h"
+
+/* ---- Temporary spill files ----
+ *
+ * Memory-hungry plan operators (hash join, hash aggregation, semi join,
+ * sort, window) keep their state in memory until it would exceed work_mem,
+ * then write rows out to anonymous temporary files and process them in
+ * pieces: hash partitions, or sorted runs that are merged back.
+ *
+ * A spill file is created (and immediately unlinked) under MSKQL_DATA_DIR,
+ * so the space is returned to the filesystem as soon as it is closed or
+ * the process exits.  Values are written one at a time in native byte
+ * order through a private staging buffer; a file is written once, rewound
+ * and read back once.  Under MSKQL_WASM spill_open always fails and
+ * operators stay in memory. */
+
+#define SPILL_BUF_SIZE  (64 * 1024)
+
+/* Hash partitioning: each spill pass splits its input SPILL_FANOUT ways on
+ * a different group of hash bits, at most SPILL_MAX_LEVEL passes deep. */
+#define SPILL_FANOUT     16
+#define SPILL_MAX_LEVEL  4
+
+/* Default work_mem: 1GB per operator, overridable with MSKQL_WORK_MEM. */
+#define SPILL_DEFAULT_WORK_MEM ((size_t)1 << 30)
+#define SPILL_MIN_WORK_MEM     ((size_t)64 * 1024)
+
+struct spill_file {
+    int       fd;        /* -1 when not open */
+    int       failed;    /* a write or read error occurred */
+    uint8_t  *buf;       /* SPILL_BUF_SIZE staging buffer, heap */
+    uint32_t  pos;       /* write: bytes buffered; read: next byte */
+    uint32_t  len;       /* read: bytes in buf */
+    uint64_t  nrows;     /* rows written (maintained by callers) */
+};
+
+/* Create an unlinked temporary file.  Returns 0 or -1 (sf->fd stays -1). */
+int  spill_open(struct spill_file *sf);
+/* Flush pending writes and seek back to the start for reading. */
+int  spill_rewind(struct spill_file *sf);
+/* Close the file and free its buffer; safe on a closed file (fd -1). */
+void spill_close(struct spill_file *sf);
+
+void spill_write(struct spill_file *sf, const void *p, size_t n);
+/* Read exactly n bytes; returns 0, or -1 at end of file or on error. */
+int  spill_read(struct spill_file *sf, void *p, size_t n);
+
+/* Encode one value: a null flag, then the fixed-size element, a u32
+ * length plus bytes for TEXT, or a u16 dimension plus floats for VECTOR.
+ * v points at the element (for TEXT, at the char * slot); NULL = SQL NULL. */
+void spill_write_value(struct spill_file *sf, enum column_type type,
+                       const void *v, uint16_t vec_dim);
+/* Decode one value into row i of cb (whose type is already set).  Strings
+ * and vectors are allocated from mem.  Returns 0, or -1 at end of file. */
+int  spill_read_value(struct spill_file *sf, struct col_block *cb, uint16_t i,
+                      struct bump_alloc *mem);
+
+/* Partition of a row hash at a given spill level.  The hash is remixed so
+ * the partition bits stay independent of the bucket bits in-memory hash
+ * tables take from the low end. */
+static inline uint32_t spill_partition(uint32_t h, uint32_t level)
+{
+    return ((h * 0x9E3779B1u) >> (28 - 4 * level)) & (SPILL_FANOUT - 1);
+}
+
+/* ---- work_mem ---- */
+
+/* Parse a PostgreSQL-style memory setting ("64kB", "4MB", "1GB", or a bare
+ * number of kilobytes).  Returns 0 and sets *out, or -1 if malformed. */
+int  spill_parse_mem(const char *s, size_t len, size_t *out);
+/* Format a byte count the way SHOW work_mem prints it. */
+void spill_format_mem(size_t bytes, char *buf, size_t bufsz);
+/* Default budget: MSKQL_WORK_MEM if set and valid, else SPILL_DEFAULT_WORK_MEM. */
+size_t spill_default_work_mem(void);
+
+#endif
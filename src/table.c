@@ -63,6 +63,91 @@ void table_add_column(struct table *t, struct column *col)
     da_push(&t->columns, c);
 }
 
+/* Copy of a dictionary with its codes array sized for cap rows (nrows used). */
+static struct flat_dict *flat_dict_copy(const struct flat_dict *src, size_t nrows, size_t cap)
+{
+    struct flat_dict *d = flat_dict_new(cap);
+    memcpy(d->codes, src->codes, nrows * sizeof(int32_t));
+    if (src->cap == 0) return d;
+    d->count = src->count;
+    d->cap = src->cap;
+    d->nslots = src->nslots;
+    d->strs = (char **)malloc(d->cap * sizeof(char *));
+    d->lens = (uint32_t *)malloc(d->cap * sizeof(uint32_t));
+    d->hashes = (uint32_t *)malloc(d->cap * sizeof(uint32_t));
+    d->slots = (uint32_t *)malloc(d->nslots * sizeof(uint32_t));
+    if (!d->strs || !d->lens || !d->hashes || !d->slots) { fprintf(stderr, "OOM: flat_dict_copy\n"); abort(); }
+    memcpy(d->lens, src->lens, d->count * sizeof(uint32_t));
+    memcpy(d->hashes, src->hashes, d->count * sizeof(uint32_t));
+    memcpy(d->slots, src->slots, d->nslots * sizeof(uint32_t));
+    for (uint32_t i = 0; i < d->count; i++) {
+        d->strs[i] = (char *)malloc(d->lens[i] + 1);
+        if (!d->strs[i]) { fprintf(stderr, "OOM: flat_dict_copy\n"); abort(); }
+        memcpy(d->strs[i], src->strs[i], d->lens[i] + 1);
+    }
+    return d;
+}
+
+/* Give dst (schema already copied) the rows of src's flat storage, a column
+ * at a time: fixed-width and VECTOR data, NULL flags, prefixes and zones are
+ * copied wholesale; TEXT goes through a copied dictionary or dst's own
+ * string heap. */
+static void table_flat_copy(struct table *dst, const struct table *src)
+{
+    const struct flat_table *sf = &src->flat;
+    size_t nrows = sf->nrows;
+    size_t cap = nrows < 16 ? 16 : nrows;
+    struct flat_table *ft = &dst->flat;
+
+    flat_table_init(ft, sf->ncols, cap);
+    memcpy(ft->col_types, sf->col_types, sf->ncols * sizeof(enum column_type));
+    memcpy(ft->col_vec_dims, sf->col_vec_dims, sf->ncols * sizeof(uint16_t));
+    flat_table_alloc_cols(ft);
+    if (sf->col_zones) {
+        flat_table_enable_zones(ft);
+        for (uint16_t c = 0; c < sf->ncols; c++)
+            memcpy(ft->col_zones[c], sf->col_zones[c],
+                   flat_zone_count(nrows) * sizeof(struct flat_zone));
+    }
+    if (sf->col_dicts) {
+        ft->col_dicts = (struct flat_dict **)calloc(sf->ncols, sizeof(struct flat_dict *));
+        if (!ft->col_dicts) { fprintf(stderr, "OOM: table_flat_copy\n"); abort(); }
+    }
+    if (sf->col_str_pfx) {
+        ft->col_str_pfx = (uint64_t **)calloc(sf->ncols, sizeof(uint64_t *));
+        if (!ft->col_str_pfx) { fprintf(stderr, "OOM: table_flat_copy\n"); abort(); }
+    }
+    ft->str_heap = flat_strheap_new();
+    ft->nrows = nrows;
+
+    for (uint16_t c = 0; c < sf->ncols; c++) {
+        memcpy(ft->col_nulls[c], sf->col_nulls[c], nrows);
+        if (sf->col_str_lens && sf->col_str_lens[c]) {
+            ft->col_str_lens[c] = (uint32_t *)flat_mem_alloc(cap * sizeof(uint32_t));
+            memcpy(ft->col_str_lens[c], sf->col_str_lens[c], nrows * sizeof(uint32_t));
+        }
+        if (sf->col_str_pfx && sf->col_str_pfx[c]) {
+            ft->col_str_pfx[c] = (uint64_t *)flat_mem_alloc(cap * sizeof(uint64_t));
+            memcpy(ft->col_str_pfx[c], sf->col_str_pfx[c], nrows * sizeof(uint64_t));
+        }
+        if (sf->col_types[c] != COLUMN_TYPE_TEXT) {
+            memcpy(ft->col_data[c], sf->col_data[c], nrows * flat_table_row_size(sf, c));
+            continue;
+        }
+        const char *const *sstrs = (const char *const *)sf->col_data[c];
+        const char **strs = (const char **)ft->col_data[c];
+        if (sf->col_dicts && sf->col_dicts[c]) {
+            struct flat_dict *d = flat_dict_copy(sf->col_dicts[c], nrows, cap);
+            ft->col_dicts[c] = d;
+            for (size_t r = 0; r < nrows; r++)
+                strs[r] = d->codes[r] >= 0 ? d->strs[d->codes[r]] : NULL;
+            continue;
+        }
+        for (size_t r = 0; r < nrows; r++)
+            if (sstrs[r]) strs[r] = flat_strheap_dup(ft->str_heap, sstrs[r], strlen(sstrs[r]));
+    }
+}
+
 void table_deep_copy(struct table *dst, const struct table *src)
 {
     memset(dst, 0, sizeof(*dst));
@@ -109,27 +194,8 @@ void table_deep_copy(struct table *dst, const struct table *src)
     da_init(&dst->indexes);
     memset(&dst->flat, 0, sizeof(dst->flat));
     memset(&dst->join_cache, 0, sizeof(dst->join_cache));
-    if (src->flat.nrows > 0 && src->flat.ncols > 0) {
-        table_flat_init_schema(dst);
-        for (size_t ri = 0; ri < src->flat.nrows; ri++) {
-            struct row r = {0};
-            da_init(&r.cells);
-            for (uint16_t c = 0; c < src->flat.ncols; c++) {
-                struct cell cv = flat_cell_at_pub(&src->flat, c, ri);
-                struct cell owned = cv;
-                if (column_type_is_text(cv.type) && cv.value.as_text)
-                    owned.value.as_text = strdup(cv.value.as_text);
-                else if (cv.type == COLUMN_TYPE_VECTOR && cv.value.as_vector && !cv.is_null) {
-                    uint16_t dim = src->columns.items[c].vector_dim;
-                    owned.value.as_vector = (float *)malloc(dim * sizeof(float));
-                    memcpy(owned.value.as_vector, cv.value.as_vector, dim * sizeof(float));
-                }
-                da_push(&r.cells, owned);
-            }
-            table_flat_append_row(dst, &r);
-            row_free(&r);
-        }
-    }
+    if (src->flat.nrows > 0 && src->flat.ncols > 0)
+        table_flat_copy(dst, src);
     /* skip indexes — they will be rebuilt if needed */
 
     /* deep-copy kind-specific union fields */
@@ -225,6 +291,11 @@ int resolve_alias_to_column(struct table *t, sv columns, sv alias)
 
 void table_flat_init_schema(struct table *t)
 {
+    if (t->undo && t->flat.nrows > 0) {
+        /* the log's row ids no longer mean anything */
+        t->undo->broken = 1;
+        t->undo = NULL;
+    }
     flat_table_free(&t->flat);
     uint16_t ncols = (uint16_t)t->columns.count;
     if (ncols == 0) return;
@@ -234,6 +305,431 @@ void table_flat_init_schema(struct table *t)
         t->flat.col_vec_dims[c] = t->columns.items[c].vector_dim;
     }
     flat_table_alloc_cols(&t->flat);
+    flat_table_enable_zones(&t->flat);
+    flat_table_enable_dicts(&t->flat);
+    flat_table_enable_str_pfx(&t->flat);
+    t->flat.str_heap = flat_strheap_new();
+}
+
+/* ---- TEXT cell storage (see "Dictionary-encoded TEXT" in block.h) ---- */
+
+/* Stop dictionary-encoding column c: every row gets its own copy of its
+ * value, as in a plain TEXT column. */
+static void flat_dict_drop(struct flat_table *ft, uint16_t c)
+{
+    struct flat_dict *d = ft->col_dicts[c];
+    const char **strs = (const char **)ft->col_data[c];
+    ft->col_dicts[c] = NULL;
+    /* codes[r] >= 0 exactly for the non-NULL values stored so far, which
+     * includes rows of a bulk append not yet counted in nrows */
+    for (size_t r = 0; r < ft->cap; r++) {
+        int32_t code = d->codes[r];
+        strs[r] = NULL;
+        if (code >= 0)
+            flat_table_set_text(ft, c, r, d->strs[code], d->lens[code]);
+    }
+    flat_dict_free(d);
+}
+
+/* Replace the TEXT value at (c, r) with s (NULL allowed), interned into
+ * the column's dictionary or copied.  Returns the stored pointer. */
+static const char *flat_text_set(struct flat_table *ft, uint16_t c, size_t r,
+                                 const char *s)
+{
+    const char **strs = (const char **)ft->col_data[c];
+    struct flat_dict *d = ft->col_dicts ? ft->col_dicts[c] : NULL;
+    if (d) {
+        int32_t code = s ? flat_dict_intern(d, s) : -1;
+        if (code >= 0 || !s) {
+            d->codes[r] = code;
+            strs[r] = s ? d->strs[code] : NULL;
+            if (ft->col_str_pfx && ft->col_str_pfx[c] && s)
+                ft->col_str_pfx[c][r] = str_pfx_n(s, d->lens[code]);
+            return strs[r];
+        }
+        /* dictionary full: s may be one of its strings, copy it first */
+        char *dup = strdup(s);
+        flat_dict_drop(ft, c);
+        strs[r] = NULL;
+        flat_table_set_text(ft, c, r, dup, strlen(dup));
+        free(dup);
+        return strs[r];
+    }
+    return flat_table_set_text(ft, c, r, s, s ? strlen(s) : 0);
+}
+
+/* Cell (c, r) became NULL. */
+static void flat_text_set_null(struct flat_table *ft, uint16_t c, size_t r)
+{
+    if (ft->col_dicts && ft->col_dicts[c])
+        ft->col_dicts[c]->codes[r] = -1;
+    else if (ft->str_heap)
+        flat_table_set_text(ft, c, r, NULL, 0);
+}
+
+/* ---- Zone-map maintenance (see "Zone maps" in block.h) ---- */
+
+/* Fold newly appended row r into its zones, starting the zone afresh when
+ * r is the first row of a block. */
+static void flat_zones_append_row(struct flat_table *ft, size_t r)
+{
+    if (!ft->col_zones) return;
+    size_t zi = r / FLAT_ZONE_ROWS;
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        struct flat_zone *z = &ft->col_zones[c][zi];
+        if (r % FLAT_ZONE_ROWS == 0) memset(z, 0, sizeof(*z));
+        flat_zone_add(z, ft, c, r);
+    }
+}
+
+static void flat_zones_remove_row(struct flat_table *ft, size_t r)
+{
+    if (!ft->col_zones) return;
+    for (uint16_t c = 0; c < ft->ncols; c++)
+        flat_zone_remove(&ft->col_zones[c][r / FLAT_ZONE_ROWS], ft, c, r);
+}
+
+static void flat_zones_add_row(struct flat_table *ft, size_t r)
+{
+    if (!ft->col_zones) return;
+    for (uint16_t c = 0; c < ft->ncols; c++)
+        flat_zone_add(&ft->col_zones[c][r / FLAT_ZONE_ROWS], ft, c, r);
+}
+
+/* ---- Transaction undo log (see table.h) ---- */
+
+/* Owned copy of cell (c, r) of ft. */
+static struct cell undo_cell_copy(const struct flat_table *ft, uint16_t c, size_t r)
+{
+    struct cell cv = flat_cell_at_pub(ft, c, r);
+    if (cv.is_null) return cv;
+    if (cv.type == COLUMN_TYPE_TEXT && cv.value.as_text) {
+        cv.value.as_text = strdup(cv.value.as_text);
+        if (!cv.value.as_text) { fprintf(stderr, "OOM: undo_cell_copy\n"); abort(); }
+    } else if (cv.type == COLUMN_TYPE_VECTOR && cv.value.as_vector) {
+        uint16_t dim = ft->col_vec_dims[c];
+        float *v = (float *)malloc(dim * sizeof(float));
+        if (!v) { fprintf(stderr, "OOM: undo_cell_copy\n"); abort(); }
+        memcpy(v, cv.value.as_vector, dim * sizeof(float));
+        cv.value.as_vector = v;
+    }
+    return cv;
+}
+
+static void undo_row_image(const struct flat_table *ft, size_t r, struct row *out)
+{
+    da_init(&out->cells);
+    for (uint16_t c = 0; c < ft->ncols; c++)
+        da_push(&out->cells, undo_cell_copy(ft, c, r));
+}
+
+static uint64_t undo_clock;
+
+uint64_t table_undo_clock(void)
+{
+    return undo_clock;
+}
+
+static struct undo_rec *undo_push(struct table *t, enum undo_kind kind)
+{
+    struct table_undo *u = t->undo;
+    struct undo_rec rec = {0};
+    rec.kind = kind;
+    rec.seq = ++undo_clock;
+    t->undo_last = rec.seq;
+    da_push(&u->recs, rec);
+    return &u->recs.items[u->recs.count - 1];
+}
+
+/* Rows are about to be appended at t->flat.nrows. */
+static void undo_note_append(struct table *t)
+{
+    struct table_undo *u = t->undo;
+    /* extend the previous append unless something was noted since */
+    if (u->recs.count > 0 && u->recs.items[u->recs.count - 1].kind == UNDO_APPEND
+        && u->recs.items[u->recs.count - 1].seq == t->undo_last)
+        return;
+    undo_push(t, UNDO_APPEND)->row = t->flat.nrows;
+}
+
+static void undo_note_row(struct table *t, size_t r)
+{
+    struct undo_rec *rec = undo_push(t, UNDO_ROW);
+    rec->row = r;
+    rec->images = (struct row *)malloc(sizeof(struct row));
+    if (!rec->images) { fprintf(stderr, "OOM: undo_note_row\n"); abort(); }
+    undo_row_image(&t->flat, r, rec->images);
+}
+
+static void undo_note_column(struct table *t, uint16_t c, const size_t *row_ids, uint16_t n)
+{
+    struct undo_rec *rec = undo_push(t, UNDO_COLUMN);
+    rec->col = c;
+    rec->n = n;
+    rec->rows = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+    rec->cells = (struct cell *)malloc((n ? n : 1) * sizeof(struct cell));
+    if (!rec->rows || !rec->cells) { fprintf(stderr, "OOM: undo_note_column\n"); abort(); }
+    memcpy(rec->rows, row_ids, n * sizeof(size_t));
+    for (uint16_t i = 0; i < n; i++)
+        rec->cells[i] = undo_cell_copy(&t->flat, c, row_ids[i]);
+}
+
+static size_t del_scan(const uint64_t *bits, size_t r, size_t n, int want);
+
+/* The ndel rows tombstoned in bits are about to be purged. */
+static void undo_note_purge(struct table *t, const uint64_t *bits, size_t ndel)
+{
+    struct undo_rec *rec = undo_push(t, UNDO_PURGE);
+    size_t n = t->flat.nrows;
+    rec->rows = (size_t *)malloc(ndel * sizeof(size_t));
+    rec->images = (struct row *)malloc(ndel * sizeof(struct row));
+    if (!rec->rows || !rec->images) { fprintf(stderr, "OOM: undo_note_purge\n"); abort(); }
+    size_t k = 0;
+    for (size_t r = del_scan(bits, 0, n, 1); r < n && k < ndel; r = del_scan(bits, r + 1, n, 1)) {
+        rec->rows[k] = r;
+        undo_row_image(&t->flat, r, &rec->images[k]);
+        k++;
+    }
+    rec->n = k;
+}
+
+/* Drop rows [n, nrows) again. */
+static void undo_truncate(struct table *t, size_t n)
+{
+    struct flat_table *ft = &t->flat;
+    if (n >= ft->nrows) return;
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        if (ft->col_types[c] != COLUMN_TYPE_TEXT) continue;
+        const char **strs = (const char **)ft->col_data[c];
+        struct flat_dict *d = ft->col_dicts ? ft->col_dicts[c] : NULL;
+        for (size_t r = n; r < ft->nrows; r++) {
+            if (d) {
+                d->codes[r] = -1;
+                strs[r] = NULL;
+            } else {
+                flat_table_set_text(ft, c, r, NULL, 0);
+            }
+        }
+    }
+    ft->nrows = n;
+    /* refold the zone the cut falls in; later zones restart on append */
+    if (ft->col_zones && n % FLAT_ZONE_ROWS != 0) {
+        for (size_t r = n - n % FLAT_ZONE_ROWS; r < n; r++)
+            flat_zones_append_row(ft, r);
+    }
+}
+
+/* Put the rows of a purge record back at their old ids: each run of
+ * surviving rows moves up past the gaps (the inverse of the purge), then
+ * the saved images are written into the gaps. */
+static void undo_unpurge(struct table *t, const struct undo_rec *rec)
+{
+    struct flat_table *ft = &t->flat;
+    size_t k = rec->n;
+    if (k == 0) return;
+    size_t total = ft->nrows + k;
+    for (size_t j = 0; j < k; j++)
+        if (rec->rows[j] >= total || (j > 0 && rec->rows[j] <= rec->rows[j - 1])) return;
+    if (total > ft->cap) {
+        size_t new_cap = ft->cap ? ft->cap * 2 : 16;
+        while (new_cap < total) new_cap *= 2;
+        flat_table_grow(ft, new_cap);
+    }
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        size_t row_sz = flat_table_row_size(ft, c);
+        uint8_t *data = (uint8_t *)ft->col_data[c];
+        uint8_t *nulls = ft->col_nulls[c];
+        uint32_t *lens = ft->col_str_lens ? ft->col_str_lens[c] : NULL;
+        uint64_t *pfx = ft->col_str_pfx ? ft->col_str_pfx[c] : NULL;
+        int32_t *codes = (ft->col_dicts && ft->col_dicts[c]) ? ft->col_dicts[c]->codes : NULL;
+        for (size_t j = k; j-- > 0; ) {
+            size_t to = rec->rows[j] + 1;
+            size_t end = j + 1 < k ? rec->rows[j + 1] : total;
+            size_t from = rec->rows[j] - j;
+            size_t cnt = end - to;
+            memmove(data + to * row_sz, data + from * row_sz, cnt * row_sz);
+            memmove(nulls + to, nulls + from, cnt);
+            if (lens)  memmove(lens + to, lens + from, cnt * sizeof(uint32_t));
+            if (pfx)   memmove(pfx + to, pfx + from, cnt * sizeof(uint64_t));
+            if (codes) memmove(codes + to, codes + from, cnt * sizeof(int32_t));
+        }
+        /* the gaps still alias the rows moved out of them */
+        for (size_t j = 0; j < k; j++) {
+            size_t r = rec->rows[j];
+            nulls[r] = 1;
+            if (ft->col_types[c] == COLUMN_TYPE_TEXT) {
+                ((const char **)ft->col_data[c])[r] = NULL;
+                if (codes) codes[r] = -1;
+            }
+        }
+    }
+    ft->nrows = total;
+    for (size_t j = 0; j < k; j++)
+        table_flat_update_row(t, rec->rows[j], &rec->images[j]);
+    if (ft->col_zones) {
+        size_t first = rec->rows[0];
+        for (size_t r = first - first % FLAT_ZONE_ROWS; r < total; r++)
+            flat_zones_append_row(ft, r);
+    }
+}
+
+void table_index_row(struct table *t, size_t r)
+{
+    struct flat_table *ft = &t->flat;
+    for (size_t i = 0; i < t->indexes.count; i++) {
+        struct index *ix = &t->indexes.items[i];
+        switch (ix->type) {
+        case INDEX_BTREE: {
+            int ok = ix->ncols > 0;
+            for (int k = 0; k < ix->ncols; k++)
+                if (ix->column_indices[k] < 0 || ix->column_indices[k] >= ft->ncols) ok = 0;
+            if (!ok) break;
+            struct cell keys[MAX_INDEX_COLS];
+            for (int k = 0; k < ix->ncols; k++)
+                keys[k] = flat_cell_at_pub(ft, (uint16_t)ix->column_indices[k], r);
+            index_insert(ix, keys, r);
+            break;
+        }
+        case INDEX_HNSW: {
+            int ci = ix->hnsw->col_idx;
+            if (ci < 0 || (uint16_t)ci >= ft->ncols) break;
+            if (!ft->col_nulls[ci][r])
+                hnsw_insert(ix->hnsw, (const float *)ft->col_data[ci] + r * ft->col_vec_dims[ci], r);
+            break;
+        }
+        }
+    }
+}
+
+/* Re-index every row of t from scratch. */
+static void table_rebuild_indexes(struct table *t)
+{
+    for (size_t i = 0; i < t->indexes.count; i++)
+        index_reset(&t->indexes.items[i]);
+    for (size_t r = 0; r < t->flat.nrows; r++)
+        table_index_row(t, r);
+}
+
+void table_undo_attach(struct table *t, struct table_undo *u, void *owner)
+{
+    if (u->ncols == 0 && t->columns.count > 0) {
+        u->serial_next = (long long *)malloc(t->columns.count * sizeof(long long));
+        if (!u->serial_next) { fprintf(stderr, "OOM: table_undo_attach\n"); abort(); }
+        for (size_t c = 0; c < t->columns.count; c++)
+            u->serial_next[c] = t->columns.items[c].serial_next;
+        u->ncols = t->columns.count;
+    }
+    u->owner = owner;
+    t->undo = u;
+}
+
+void table_undo_append(struct table_undo *dst, struct table_undo *src)
+{
+    for (size_t i = 0; i < src->recs.count; i++)
+        da_push(&dst->recs, src->recs.items[i]);
+    da_free(&src->recs);
+    if (dst->ncols == 0) {
+        dst->serial_next = src->serial_next;
+        dst->ncols = src->ncols;
+        src->serial_next = NULL;
+        src->ncols = 0;
+    }
+    dst->broken |= src->broken;
+}
+
+void table_undo_restored(struct table *t, struct table *old, uint64_t since)
+{
+    uint64_t now = ++undo_clock;
+    if (old) {
+        t->undo_gaps = old->undo_gaps;
+        memset(&old->undo_gaps, 0, sizeof(old->undo_gaps));
+        t->undo = old->undo;
+        old->undo = NULL;
+    }
+    if (!old || old->undo_last > since) {
+        struct undo_gap g = { since, now };
+        da_push(&t->undo_gaps, g);
+    }
+    t->undo_last = now;
+}
+
+static int undo_in_gap(const struct table *t, uint64_t seq)
+{
+    for (size_t i = 0; i < t->undo_gaps.count; i++)
+        if (t->undo_gaps.items[i].lo < seq && seq < t->undo_gaps.items[i].hi)
+            return 1;
+    return 0;
+}
+
+int table_undo_apply(struct table *t, struct table_undo *u)
+{
+    if (u->broken) return -1;
+    if (t->undo == u) t->undo = NULL;
+    for (size_t i = u->recs.count; i-- > 0; ) {
+        struct undo_rec *rec = &u->recs.items[i];
+        if (undo_in_gap(t, rec->seq)) continue;
+        switch (rec->kind) {
+        case UNDO_APPEND:
+            undo_truncate(t, rec->row);
+            break;
+        case UNDO_ROW:
+            table_flat_update_row(t, rec->row, rec->images);
+            break;
+        case UNDO_COLUMN:
+            for (size_t j = 0; j < rec->n; j++) {
+                size_t r = rec->rows[j];
+                if (r >= t->flat.nrows || rec->col >= t->flat.ncols) continue;
+                struct row cur = {0};
+                da_init(&cur.cells);
+                for (uint16_t c = 0; c < t->flat.ncols; c++)
+                    da_push(&cur.cells, flat_cell_at_pub(&t->flat, c, r));
+                cur.cells.items[rec->col] = rec->cells[j];
+                table_flat_update_row(t, r, &cur);
+                da_free(&cur.cells);
+            }
+            break;
+        case UNDO_PURGE:
+            undo_unpurge(t, rec);
+            break;
+        }
+    }
+    for (size_t c = 0; c < u->ncols && c < t->columns.count; c++)
+        t->columns.items[c].serial_next = u->serial_next[c];
+    if (u->recs.count > 0 && t->indexes.count > 0)
+        table_rebuild_indexes(t);
+    return 0;
+}
+
+void table_undo_free(struct table_undo *u)
+{
+    for (size_t i = 0; i < u->recs.count; i++) {
+        struct undo_rec *rec = &u->recs.items[i];
+        switch (rec->kind) {
+        case UNDO_APPEND:
+            break;
+        case UNDO_ROW:
+            row_free(rec->images);
+            break;
+        case UNDO_COLUMN:
+            for (size_t j = 0; j < rec->n; j++) {
+                struct cell *cv = &rec->cells[j];
+                if (cv->is_null) continue;
+                if (cv->type == COLUMN_TYPE_TEXT) free(cv->value.as_text);
+                else if (cv->type == COLUMN_TYPE_VECTOR) free(cv->value.as_vector);
+            }
+            break;
+        case UNDO_PURGE:
+            for (size_t j = 0; j < rec->n; j++)
+                row_free(&rec->images[j]);
+            break;
+        }
+        free(rec->rows);
+        free(rec->images);
+        free(rec->cells);
+    }
+    da_free(&u->recs);
+    free(u->serial_next);
+    memset(u, 0, sizeof(*u));
 }
 
 void table_flat_append_row(struct table *t, const struct row *row)
@@ -243,6 +739,7 @@ void table_flat_append_row(struct table *t, const struct row *row)
         table_flat_init_schema(t);
     uint16_t ncols = t->flat.ncols;
     if (ncols == 0) return;
+    if (t->undo) undo_note_append(t);
 
     /* Grow if needed */
     if (t->flat.nrows >= t->flat.cap) {
@@ -257,6 +754,7 @@ void table_flat_append_row(struct table *t, const struct row *row)
         enum column_type ct = t->flat.col_types[c];
         if (cell->is_null) {
             t->flat.col_nulls[c][r] = 1;
+            if (ct == COLUMN_TYPE_TEXT) flat_text_set_null(&t->flat, c, r);
             continue;
         }
         t->flat.col_nulls[c][r] = 0;
@@ -282,10 +780,7 @@ void table_flat_append_row(struct table *t, const struct row *row)
         case COLUMN_TYPE_NUMERIC:   ((double *)t->flat.col_data[c])[r] = cell->value.as_numeric; break;
         case COLUMN_TYPE_INTERVAL:  ((struct interval *)t->flat.col_data[c])[r] = cell->value.as_interval; break;
         case COLUMN_TYPE_TEXT: {
-            const char *prev = ((const char **)t->flat.col_data[c])[r];
-            free((char *)prev);
-            const char *dup = cell->value.as_text ? strdup(cell->value.as_text) : NULL;
-            ((const char **)t->flat.col_data[c])[r] = dup;
+            const char *dup = flat_text_set(&t->flat, c, r, cell->value.as_text);
             if (t->flat.col_str_lens && t->flat.col_str_lens[c] && dup)
                 t->flat.col_str_lens[c][r] = (uint32_t)strlen(dup);
             break;
@@ -300,17 +795,24 @@ void table_flat_append_row(struct table *t, const struct row *row)
         }
         }
     }
+    flat_zones_append_row(&t->flat, r);
     t->flat.nrows++;
 }
 
 void table_flat_update_row(struct table *t, size_t row_idx, const struct row *row)
 {
     if (row_idx >= t->flat.nrows || t->flat.ncols == 0) return;
+    if (t->undo) undo_note_row(t, row_idx);
     uint16_t ncols = t->flat.ncols;
+    flat_zones_remove_row(&t->flat, row_idx);
     for (uint16_t c = 0; c < ncols && c < (uint16_t)row->cells.count; c++) {
         const struct cell *cell = &row->cells.items[c];
         enum column_type ct = t->flat.col_types[c];
-        if (cell->is_null) { t->flat.col_nulls[c][row_idx] = 1; continue; }
+        if (cell->is_null) {
+            t->flat.col_nulls[c][row_idx] = 1;
+            if (ct == COLUMN_TYPE_TEXT) flat_text_set_null(&t->flat, c, row_idx);
+            continue;
+        }
         t->flat.col_nulls[c][row_idx] = 0;
         int32_t coerced_bool2 = 0;
         if (ct == COLUMN_TYPE_BOOLEAN && cell->type == COLUMN_TYPE_TEXT && cell->value.as_text) {
@@ -333,10 +835,7 @@ void table_flat_update_row(struct table *t, size_t row_idx, const struct row *ro
         case COLUMN_TYPE_NUMERIC:   ((double *)t->flat.col_data[c])[row_idx] = cell->value.as_numeric; break;
         case COLUMN_TYPE_INTERVAL:  ((struct interval *)t->flat.col_data[c])[row_idx] = cell->value.as_interval; break;
         case COLUMN_TYPE_TEXT: {
-            const char *prev = ((const char **)t->flat.col_data[c])[row_idx];
-            free((char *)prev);
-            const char *dup = cell->value.as_text ? strdup(cell->value.as_text) : NULL;
-            ((const char **)t->flat.col_data[c])[row_idx] = dup;
+            const char *dup = flat_text_set(&t->flat, c, row_idx, cell->value.as_text);
             if (t->flat.col_str_lens && t->flat.col_str_lens[c] && dup)
                 t->flat.col_str_lens[c][row_idx] = (uint32_t)strlen(dup);
             break;
@@ -351,35 +850,161 @@ void table_flat_update_row(struct table *t, size_t row_idx, const struct row *ro
         }
         }
     }
+    flat_zones_add_row(&t->flat, row_idx);
 }
 
-void table_flat_delete_row(struct table *t, size_t row_idx)
+void table_flat_update_col(struct table *t, uint16_t c, const size_t *row_ids,
+                           const struct col_block *vals, uint16_t n)
 {
-    if (row_idx >= t->flat.nrows || t->flat.ncols == 0) return;
-    uint16_t ncols = t->flat.ncols;
-    /* free individually-owned text strings in the row being deleted */
+    struct flat_table *ft = &t->flat;
+    if (c >= ft->ncols) return;
+    if (t->undo) undo_note_column(t, c, row_ids, n);
+    enum column_type ct = ft->col_types[c];
+    size_t esz = col_type_elem_size(ct);
+    const uint8_t *vnulls = cb_nulls(vals);
+    for (uint16_t i = 0; i < n; i++) {
+        size_t r = row_ids[i];
+        struct flat_zone *z = ft->col_zones ? &ft->col_zones[c][r / FLAT_ZONE_ROWS] : NULL;
+        if (z) flat_zone_remove(z, ft, c, r);
+        ft->col_nulls[c][r] = vnulls[i];
+        if (ct == COLUMN_TYPE_TEXT) {
+            if (vnulls[i]) {
+                flat_text_set_null(ft, c, r);
+            } else {
+                const char *dup = flat_text_set(ft, c, r, cb_str(vals)[i]);
+                if (ft->col_str_lens && ft->col_str_lens[c] && dup)
+                    ft->col_str_lens[c][r] = (uint32_t)strlen(dup);
+            }
+        } else if (!vnulls[i]) {
+            memcpy((char *)ft->col_data[c] + r * esz, cb_data_ptr(vals, i), esz);
+        }
+        if (z) flat_zone_add(z, ft, c, r);
+    }
+}
+
+void table_flat_mark_deleted(struct table *t, size_t row_idx)
+{
+    if (row_idx >= t->flat.nrows || table_row_deleted(t, row_idx)) return;
+    if (!t->del_bits) {
+        t->del_bits = (uint64_t *)calloc((t->flat.nrows + 63) / 64, sizeof(uint64_t));
+        if (!t->del_bits) { fprintf(stderr, "OOM: table_flat_mark_deleted\n"); abort(); }
+    }
+    t->del_bits[row_idx >> 6] |= (uint64_t)1 << (row_idx & 63);
+    t->ndeleted++;
+}
+
+/* First row in [r, n) whose tombstone bit equals want, or n. */
+static size_t del_scan(const uint64_t *bits, size_t r, size_t n, int want)
+{
+    while (r < n) {
+        uint64_t w = want ? bits[r >> 6] : ~bits[r >> 6];
+        w >>= (r & 63);
+        if (w) {
+            r += (size_t)__builtin_ctzll(w);
+            return r < n ? r : n;
+        }
+        r = (r | 63) + 1;
+    }
+    return n;
+}
+
+size_t table_flat_purge_deleted(struct table *t)
+{
+    struct flat_table *ft = &t->flat;
+    uint64_t *bits = t->del_bits;
+    size_t ndel = t->ndeleted;
+    t->del_bits = NULL;
+    t->ndeleted = 0;
+    if (!bits) return 0;
+    if (ndel == 0 || ft->ncols == 0) { free(bits); return 0; }
+    if (t->undo) undo_note_purge(t, bits, ndel);
+
+    size_t n = ft->nrows;
+    size_t new_n = n - ndel;
+    size_t first = del_scan(bits, 0, n, 1);
+    uint16_t ncols = ft->ncols;
+
+    /* release the text values of the deleted rows
+     * (dictionary-encoded columns keep theirs in the dictionary) */
+    for (uint16_t c = 0; c < ncols; c++) {
+        if (ft->col_types[c] != COLUMN_TYPE_TEXT) continue;
+        if (ft->col_dicts && ft->col_dicts[c]) continue;
+        for (size_t r = first; r < n; r = del_scan(bits, r + 1, n, 1))
+            if (!ft->col_nulls[c][r]) flat_table_set_text(ft, c, r, NULL, 0);
+    }
+
+    /* move each run of surviving rows down over the gaps */
     for (uint16_t c = 0; c < ncols; c++) {
-        if (t->flat.col_types[c] == COLUMN_TYPE_TEXT && !t->flat.col_nulls[c][row_idx]) {
-            const char *s = ((const char **)t->flat.col_data[c])[row_idx];
-            free((char *)s);
-            ((const char **)t->flat.col_data[c])[row_idx] = NULL;
+        size_t esz = col_type_elem_size(ft->col_types[c]);
+        size_t mul = (ft->col_types[c] == COLUMN_TYPE_VECTOR) ? ft->col_vec_dims[c] : 1;
+        size_t row_sz = esz * mul;
+        uint8_t *data = (uint8_t *)ft->col_data[c];
+        uint8_t *nulls = ft->col_nulls[c];
+        uint32_t *lens = ft->col_str_lens ? ft->col_str_lens[c] : NULL;
+        uint64_t *pfx = ft->col_str_pfx ? ft->col_str_pfx[c] : NULL;
+        int32_t *codes = (ft->col_dicts && ft->col_dicts[c]) ? ft->col_dicts[c]->codes : NULL;
+        size_t w = first;
+        for (size_t a = del_scan(bits, first, n, 0); a < n; ) {
+            size_t e = del_scan(bits, a, n, 1);
+            size_t k = e - a;
+            memmove(data + w * row_sz, data + a * row_sz, k * row_sz);
+            memmove(nulls + w, nulls + a, k);
+            if (lens)  memmove(lens + w, lens + a, k * sizeof(uint32_t));
+            if (pfx)   memmove(pfx + w, pfx + a, k * sizeof(uint64_t));
+            if (codes) memmove(codes + w, codes + a, k * sizeof(int32_t));
+            w += k;
+            a = del_scan(bits, e, n, 0);
         }
     }
-    size_t tail = t->flat.nrows - row_idx - 1;
-    if (tail > 0) {
-        for (uint16_t c = 0; c < ncols; c++) {
-            size_t esz = col_type_elem_size(t->flat.col_types[c]);
-            size_t mul = (t->flat.col_types[c] == COLUMN_TYPE_VECTOR) ? t->flat.col_vec_dims[c] : 1;
-            size_t row_sz = esz * mul;
-            uint8_t *data = (uint8_t *)t->flat.col_data[c];
-            memmove(data + row_idx * row_sz, data + (row_idx + 1) * row_sz, tail * row_sz);
-            memmove(t->flat.col_nulls[c] + row_idx, t->flat.col_nulls[c] + row_idx + 1, tail);
-            if (t->flat.col_str_lens && t->flat.col_str_lens[c])
-                memmove(t->flat.col_str_lens[c] + row_idx, t->flat.col_str_lens[c] + row_idx + 1,
-                        tail * sizeof(uint32_t));
+    ft->nrows = new_n;
+    /* the vacated tail slots still alias rows moved out of them */
+    for (uint16_t c = 0; c < ncols; c++) {
+        if (ft->col_types[c] != COLUMN_TYPE_TEXT) continue;
+        for (size_t r = new_n; r < n; r++) {
+            ((const char **)ft->col_data[c])[r] = NULL;
+            flat_text_set_null(ft, c, r);
+        }
+    }
+
+    /* zones before the first deleted row are untouched */
+    if (ft->col_zones) {
+        for (size_t r = first - first % FLAT_ZONE_ROWS; r < new_n; r++)
+            flat_zones_append_row(ft, r);
+    }
+
+    if (t->indexes.count > 0) {
+        size_t nwords = (n + 63) / 64;
+        size_t *rank = (size_t *)malloc(nwords * sizeof(size_t));
+        if (!rank) { fprintf(stderr, "OOM: table_flat_purge_deleted\n"); abort(); }
+        size_t acc = 0;
+        for (size_t w = 0; w < nwords; w++) {
+            rank[w] = acc;
+            acc += (size_t)__builtin_popcountll(bits[w]);
         }
+        for (size_t i = 0; i < t->indexes.count; i++) {
+            struct index *ix = &t->indexes.items[i];
+            switch (ix->type) {
+            case INDEX_BTREE:
+                index_remap_rows(ix, bits, rank);
+                break;
+            case INDEX_HNSW: {
+                /* graph node ids are positional: rebuild from the survivors */
+                index_reset(ix);
+                int ci = ix->hnsw->col_idx;
+                if (ci < 0 || (uint16_t)ci >= ncols) break;
+                uint16_t dim = ft->col_vec_dims[ci];
+                const float *vecs = (const float *)ft->col_data[ci];
+                for (size_t r = 0; r < new_n; r++)
+                    if (!ft->col_nulls[ci][r])
+                        hnsw_insert(ix->hnsw, vecs + r * dim, r);
+                break;
+            }
+            }
+        }
+        free(rank);
     }
-    t->flat.nrows--;
+    free(bits);
+    return ndel;
 }
 
 void table_flat_append_rows_bulk(struct table *t, struct row *rows, size_t count)
@@ -390,6 +1015,7 @@ void table_flat_append_rows_bulk(struct table *t, struct row *rows, size_t count
         table_flat_init_schema(t);
     uint16_t ncols = t->flat.ncols;
     if (ncols == 0) return;
+    if (t->undo) undo_note_append(t);
 
     /* Pre-grow once */
     size_t needed = t->flat.nrows + count;
@@ -499,15 +1125,15 @@ void table_flat_append_rows_bulk(struct table *t, struct row *rows, size_t count
             break;
         }
         case COLUMN_TYPE_TEXT: {
-            const char **dst = (const char **)t->flat.col_data[c] + base;
             uint32_t *lens = (t->flat.col_str_lens && t->flat.col_str_lens[c])
                            ? t->flat.col_str_lens[c] + base : NULL;
             for (size_t r = 0; r < count; r++) {
                 const struct cell *cell = &rows[r].cells.items[c];
                 nulls[r] = cell->is_null;
-                if (!cell->is_null) {
-                    const char *dup = cell->value.as_text ? strdup(cell->value.as_text) : NULL;
-                    dst[r] = dup;
+                if (cell->is_null) {
+                    flat_text_set_null(&t->flat, c, base + r);
+                } else {
+                    const char *dup = flat_text_set(&t->flat, c, base + r, cell->value.as_text);
                     if (lens && dup)
                         lens[r] = (uint32_t)strlen(dup);
                 }
@@ -536,9 +1162,65 @@ void table_flat_append_rows_bulk(struct table *t, struct row *rows, size_t count
         }
         }
     }
+    for (size_t r = 0; r < count; r++)
+        flat_zones_append_row(&t->flat, base + r);
     t->flat.nrows += count;
 }
 
+void table_flat_compact_strings(struct table *t)
+{
+    struct flat_table *ft = &t->flat;
+    struct flat_strheap *old = ft->str_heap;
+    if (!old) return;
+    ft->str_heap = flat_strheap_new();
+    for (uint16_t c = 0; c < ft->ncols; c++) {
+        if (ft->col_types[c] != COLUMN_TYPE_TEXT) continue;
+        if (ft->col_dicts && ft->col_dicts[c]) continue;
+        const char **strs = (const char **)ft->col_data[c];
+        for (size_t r = 0; r < ft->nrows; r++) {
+            if (!strs[r]) continue;
+            strs[r] = flat_strheap_dup(ft->str_heap, strs[r], strlen(strs[r]));
+        }
+    }
+    flat_strheap_free(old);
+}
+
+int table_col_ascending(struct table *t, int col)
+{
+    struct flat_table *ft = &t->flat;
+    if (col < 0 || col >= 64 || col >= ft->ncols || !ft->col_zones) return 0;
+    if (flat_zone_kind_of(ft->col_types[col]) != FLAT_ZONE_INT) return 0;
+    if (t->order_gen != t->generation) {
+        t->order_gen = t->generation;
+        t->order_checked = 0;
+        t->order_asc = 0;
+    }
+    uint64_t bit = 1ULL << col;
+    if (t->order_checked & bit) return (t->order_asc & bit) != 0;
+    t->order_checked |= bit;
+
+    /* zones must not overlap: a later zone never starts below an earlier max */
+    const struct flat_zone *zones = ft->col_zones[col];
+    size_t nz = flat_zone_count(ft->nrows);
+    int64_t hi = INT64_MIN;
+    for (size_t z = 0; z < nz; z++) {
+        if (zones[z].nvals == 0) continue;
+        if (zones[z].min.i < hi) return 0;
+        hi = zones[z].max.i;
+    }
+
+    const uint8_t *nulls = ft->col_nulls[col];
+    int64_t prev = INT64_MIN;
+    for (size_t r = 0; r < ft->nrows; r++) {
+        if (nulls[r]) continue;
+        int64_t v = flat_zone_int_at(ft, (uint16_t)col, r);
+        if (v < prev) return 0;
+        prev = v;
+    }
+    t->order_asc |= bit;
+    return 1;
+}
+
 struct cell flat_cell_at_pub(const struct flat_table *ft, uint16_t c, size_t ri)
 {
     struct cell cell = {0};
@@ -589,7 +1271,9 @@ void table_free(struct table *t)
     for (size_t i = 0; i < t->indexes.count; i++)
         index_free(&t->indexes.items[i]);
     da_free(&t->indexes);
+    da_free(&t->undo_gaps);
     flat_table_free(&t->flat);
+    free(t->del_bits);
     if (t->join_cache.valid) {
         flat_table_free(&t->join_cache.ft);
         free(t->join_cache.hashes);
@@ -597,6 +1281,11 @@ void table_free(struct table *t)
         free(t->join_cache.buckets);
         free(t->join_cache.ctrl);
         free(t->join_cache.slot_entry);
+        free(t->join_cache.part_start);
+        free(t->join_cache.part_boff);
+        free(t->join_cache.part_bmask);
+        free(t->join_cache.col_map);
+        free(t->join_cache.key_cols);
     }
 
     /* Free kind-specific union fields */
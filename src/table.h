@@ -9,12 +9,14 @@
 #include "block.h"
 #include "diskio.h"
 
-/* Cached hash join build result for a specific join key column.
+/* Cached hash join build result for a specific set of join key columns.
  * Invalidated when table->generation changes.
  * Uses struct flat_table for the columnar data arrays. */
 struct join_cache {
     uint64_t         generation; /* generation when cache was built */
-    int              key_col;    /* inner key column index */
+    int             *key_cols;   /* [nkeys] inner key column indices */
+    uint16_t         nkeys;
+    int             *col_map;    /* [ft.ncols] table column of each cached column */
     struct flat_table ft;        /* columnar data */
     uint32_t        *hashes;     /* [ft.nrows] hash values */
     uint32_t        *nexts;      /* [ft.nrows] next pointers */
@@ -25,6 +27,12 @@ struct join_cache {
     uint32_t        *slot_entry; /* [nslots] entry index per slot */
     uint32_t         nslots;     /* power of 2 */
     uint32_t         slot_mask;  /* nslots - 1 */
+    /* radix partitioning of a parallel build (nparts == 0: single table) */
+    uint32_t         nparts;
+    uint32_t         part_shift;
+    uint32_t        *part_start; /* [nparts + 1] */
+    uint32_t        *part_boff;  /* [nparts] */
+    uint32_t        *part_bmask; /* [nparts] */
     int              valid;
 };
 
@@ -58,6 +66,60 @@ static inline int table_is_writable(enum table_kind kind)
     __builtin_unreachable();
 }
 
+/* ---- Transaction undo log ----
+ *
+ * Inside a transaction, INSERT, UPDATE and DELETE on a TABLE_MEMORY table
+ * do not copy the table.  The snapshot (database.c) points t->undo at its
+ * log for the table, and the table_flat_* row mutators record the state of
+ * each row before they change it:
+ *
+ *   UNDO_APPEND  rows were appended after row `row` (consecutive appends
+ *                share one record): truncate back to it
+ *   UNDO_ROW     row `row` held images[0]
+ *   UNDO_COLUMN  column col of rows[i] held cells[i] (vectorized UPDATE)
+ *   UNDO_PURGE   rows[i] (ascending, ids before the purge) held images[i]
+ *
+ * ROLLBACK replays a log backwards with table_undo_apply; COMMIT only frees
+ * it.  Either way the cost follows the rows the transaction touched, not
+ * the size of the table.  Statements that rebuild flat storage (TRUNCATE,
+ * ALTER TABLE, DROP) still take a whole-table copy and stop the log.
+ *
+ * Records carry a database-wide clock.  When a transaction holding a copy
+ * rolls back while another connection's log is attached, the records
+ * noted between the copy and the restore describe rows that no longer
+ * exist: the table keeps that clock interval in undo_gaps and replays skip
+ * it, so the other log stays usable. */
+enum undo_kind {
+    UNDO_APPEND,
+    UNDO_ROW,
+    UNDO_COLUMN,
+    UNDO_PURGE
+};
+
+struct undo_rec {
+    enum undo_kind kind;
+    uint16_t     col;       /* UNDO_COLUMN */
+    size_t       row;       /* UNDO_APPEND, UNDO_ROW */
+    size_t       n;         /* UNDO_COLUMN, UNDO_PURGE: entries in rows[] */
+    size_t      *rows;      /* UNDO_COLUMN, UNDO_PURGE */
+    struct row  *images;    /* UNDO_ROW: 1, UNDO_PURGE: n (owned cells) */
+    struct cell *cells;     /* UNDO_COLUMN: n (owned) */
+    uint64_t     seq;       /* undo clock when recorded */
+};
+
+/* records with lo < seq < hi were discarded by a whole-table restore */
+struct undo_gap {
+    uint64_t lo, hi;
+};
+
+struct table_undo {
+    DYNAMIC_ARRAY(struct undo_rec) recs;
+    void      *owner;       /* the snapshot keeping this log */
+    long long *serial_next; /* [ncols] column serial_next before the first write */
+    size_t     ncols;       /* 0 until the log is first attached */
+    int        broken;      /* flat storage was rebuilt under the log */
+};
+
 struct table {
     enum table_kind kind;
     // TODO: STRINGVIEW OPPORTUNITY: name is strdup'd from sv-originated strings in most
@@ -69,6 +131,21 @@ struct table {
     DYNAMIC_ARRAY(struct index) indexes;
     struct flat_table flat;    /* primary columnar storage */
     struct join_cache join_cache;
+    /* table_col_ascending results, valid while order_gen == generation */
+    uint64_t order_gen;
+    uint64_t order_checked;    /* bit c: column c has been checked */
+    uint64_t order_asc;        /* bit c: column c is ascending */
+    /* DELETE tombstones: bit r of del_bits set = row r of flat is deleted
+     * but still holds its slot, so row ids stay stable while a statement
+     * marks rows.  table_flat_purge_deleted removes them all in one pass;
+     * del_bits is NULL whenever no tombstones are pending. */
+    uint64_t *del_bits;
+    size_t    ndeleted;
+    /* transaction undo log receiving this table's row changes, or NULL;
+     * owned by the snapshot (see "Transaction undo log") */
+    struct table_undo *undo;
+    uint64_t undo_last;        /* seq of the newest record noted on this table */
+    DYNAMIC_ARRAY(struct undo_gap) undo_gaps;
 
     union {
         struct {
@@ -104,16 +181,63 @@ void table_flat_init_schema(struct table *t);
  * Text pointers are stored by reference (same ownership as row-store). */
 void table_flat_append_row(struct table *t, const struct row *row);
 
+/* Add row r of t->flat to every index of t (B-tree keys and HNSW vectors). */
+void table_index_row(struct table *t, size_t r);
+
 /* Patch one row in t->flat after an UPDATE (row_idx must be < t->flat.nrows). */
 void table_flat_update_row(struct table *t, size_t row_idx, const struct row *row);
 
-/* Remove one row from t->flat by shifting rows [row_idx+1..nrows) left by one. */
-void table_flat_delete_row(struct table *t, size_t row_idx);
+/* Store vals row i into column c of row row_ids[i] of t->flat (i < n), as a
+ * vectorized UPDATE does.  vals has c's type; c must not be ENUM or VECTOR,
+ * and TEXT values must not point into t->flat. */
+void table_flat_update_col(struct table *t, uint16_t c, const size_t *row_ids,
+                           const struct col_block *vals, uint16_t n);
+
+/* Tombstone row row_idx of t->flat (no-op if already marked).  The row
+ * stays in place until table_flat_purge_deleted. */
+void table_flat_mark_deleted(struct table *t, size_t row_idx);
+
+static inline int table_row_deleted(const struct table *t, size_t row_idx)
+{
+    return t->del_bits && ((t->del_bits[row_idx >> 6] >> (row_idx & 63)) & 1);
+}
+
+/* Physically remove every tombstoned row: one pass over each column moves
+ * the surviving rows down, zone maps are refolded from the first deleted
+ * row on, and index row ids are renumbered.  Returns the rows removed. */
+size_t table_flat_purge_deleted(struct table *t);
 
 /* Append multiple rows to t->flat in a single batch (pre-grows once).
  * rows[0..count) must each have cells.count >= t->columns.count. */
 void table_flat_append_rows_bulk(struct table *t, struct row *rows, size_t count);
 
+/* Copy the live TEXT values of t->flat into a fresh string heap and drop
+ * the old one, reclaiming overwritten and deleted values.  Invalidates
+ * every pointer into the table's text; callers bump t->generation. */
+void table_flat_compact_strings(struct table *t);
+
+/* 1 if the non-NULL values of integer-class column col of t->flat never
+ * decrease in row order.  Zone maps reject most unordered columns without
+ * touching rows; the answer is cached until t->generation changes. */
+int table_col_ascending(struct table *t, int col);
+
+/* Start logging t's row changes into u (see "Transaction undo log"); the
+ * first attach records t's SERIAL counters. */
+void table_undo_attach(struct table *t, struct table_undo *u, void *owner);
+/* Move src's records to the end of dst (a nested transaction committed
+ * into its parent).  dst takes src's SERIAL counters if it has none. */
+void table_undo_append(struct table_undo *dst, struct table_undo *src);
+/* Undo every record of u on t, newest first, then rebuild t's indexes.
+ * Returns -1 (t untouched) if u is broken. */
+int  table_undo_apply(struct table *t, struct table_undo *u);
+/* Current value of the undo clock. */
+uint64_t table_undo_clock(void);
+/* t was just put back to its state at undo clock `since`, replacing old
+ * (NULL if old was dropped).  Moves old's gaps and attached log over to t
+ * and adds the gap of records the restore discarded. */
+void table_undo_restored(struct table *t, struct table *old, uint64_t since);
+void table_undo_free(struct table_undo *u);
+
 /* Read one cell from the flat store at (col, row_idx).
  * Returns a struct cell by value; caller owns nothing (text ptr aliases flat). */
 struct cell flat_cell_at_pub(const struct flat_table *ft, uint16_t c, size_t ri);
@@ -163,6 +163,8 @@ static const char *resolve_col_name(struct query *q, struct database *db,
             case WIN_SUM:          return "sum";
             case WIN_COUNT:        return "count";
             case WIN_AVG:          return "avg";
+            case WIN_MIN:          return "min";
+            case WIN_MAX:          return "max";
             }
         }
         return "?";
@@ -690,6 +690,49 @@ static void test_per_connection_txn_isolation(void)
     pg_close(b);
 }
 
+/* ------------------------------------------------------------------ */
+/*  Test 10: Interleaved rollbacks on one table                        */
+/*                                                                     */
+/*  B logs its UPDATE; A's UPDATE of the same table then falls back to */
+/*  a table copy.  A's ROLLBACK restores the copy, and B's ROLLBACK    */
+/*  must still undo B's own change.                                    */
+/* ------------------------------------------------------------------ */
+
+static void test_interleaved_rollback(void)
+{
+    printf("  test: interleaved_rollback\n");
+
+    int setup = tcp_connect();
+    if (setup < 0) { check("txn_rb: connect setup", 0); return; }
+    if (pg_startup(setup) != 0) { check("txn_rb: startup setup", 0); close(setup); return; }
+    pg_query(setup, "CREATE TABLE txn_rb (id INT, v INT)", NULL, 0);
+    pg_query(setup, "INSERT INTO txn_rb VALUES (1, 10), (2, 20)", NULL, 0);
+    pg_close(setup);
+
+    int a = tcp_connect();
+    if (a < 0) { check("txn_rb: connect A", 0); return; }
+    if (pg_startup(a) != 0) { check("txn_rb: startup A", 0); close(a); return; }
+    int b = tcp_connect();
+    if (b < 0) { check("txn_rb: connect B", 0); close(a); return; }
+    if (pg_startup(b) != 0) { check("txn_rb: startup B", 0); close(a); close(b); return; }
+
+    pg_query(b, "BEGIN", NULL, 0);
+    pg_query(b, "UPDATE txn_rb SET v = 999 WHERE id = 1", NULL, 0);
+    pg_query(a, "BEGIN", NULL, 0);
+    pg_query(a, "UPDATE txn_rb SET v = 888 WHERE id = 2", NULL, 0);
+    int status_a = pg_query(a, "ROLLBACK", NULL, 0);
+    check("txn_rb: A is idle after ROLLBACK", status_a == 'I');
+    int status_b = pg_query(b, "ROLLBACK", NULL, 0);
+    check("txn_rb: B is idle after ROLLBACK", status_b == 'I');
+
+    char data[4096] = {0};
+    pg_query(a, "SELECT id, v FROM txn_rb ORDER BY id", data, sizeof(data));
+    check("txn_rb: both rollbacks undone", strcmp(data, "1|10\n2|20\n") == 0);
+
+    pg_close(a);
+    pg_close(b);
+}
+
 /* ------------------------------------------------------------------ */
 /*  main                                                               */
 /* ------------------------------------------------------------------ */
@@ -712,6 +755,7 @@ int main(void)
     test_txn_disconnect_no_rollback();
     test_txn_state_leak_across_connections();
     test_per_connection_txn_isolation();
+    test_interleaved_rollback();
     test_zero_length_query();
     test_rapid_connect_disconnect();
     test_oversized_message();
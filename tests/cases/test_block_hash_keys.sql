@@ -0,0 +1,72 @@
+-- hash kernels: joins, GROUP BY, DISTINCT and IN across integer widths, FLOAT -0.0, TEXT, INTERVAL and NULL keys
+-- setup:
+CREATE TABLE k (s SMALLINT, i INT, b BIGINT, f FLOAT, t TEXT);
+INSERT INTO k SELECT n % 50, n % 50, n % 50, (n % 7) - 3, 'key-' || (n % 13) FROM generate_series(1, 3000) AS g(n);
+INSERT INTO k VALUES (NULL, NULL, NULL, NULL, NULL);
+INSERT INTO k VALUES (7, 7, 7, -0.0, 'key-0'), (7, 7, 7, 0.0, 'a-much-longer-key-value');
+CREATE TABLE r (id BIGINT, label TEXT);
+INSERT INTO r SELECT n, 'L' || n FROM generate_series(0, 60) AS g(n);
+INSERT INTO r VALUES (NULL, 'none');
+CREATE TABLE iv (d INTERVAL, n INT);
+INSERT INTO iv VALUES ('1 day', 1), ('2 days', 2), ('1 day', 3), (NULL, 4), ('1 mon', 5);
+-- input:
+SELECT COUNT(*) FROM (SELECT k.s FROM k JOIN r ON k.s = r.id) AS x;
+SELECT COUNT(*) FROM (SELECT k.i FROM k JOIN r ON k.i = r.id) AS x;
+SELECT COUNT(*) FROM (SELECT k.b FROM k JOIN r ON k.b = r.id WHERE r.label = 'L7') AS x;
+SELECT f, COUNT(*) FROM k GROUP BY f ORDER BY f;
+SELECT t, COUNT(*) FROM k WHERE i = 7 GROUP BY t ORDER BY t;
+SELECT s, t, COUNT(*) FROM k WHERE i < 2 OR i IS NULL GROUP BY s, t ORDER BY s, t LIMIT 6;
+SELECT d, COUNT(*) FROM iv GROUP BY d ORDER BY d;
+SELECT COUNT(*) FROM (SELECT DISTINCT i, t FROM k) AS d;
+SELECT n FROM iv WHERE d IN (SELECT d FROM iv WHERE n > 2) ORDER BY n;
+SELECT r.id, r.label, k.t FROM r LEFT JOIN k ON k.s = r.id ORDER BY r.id DESC LIMIT 4;
+SELECT id FROM r WHERE id IN (SELECT b FROM k WHERE b > 45) ORDER BY id;
+-- expected output:
+3002
+3002
+62
+-3|428
+-2|429
+-1|429
+0|431
+1|429
+2|428
+3|428
+|1
+a-much-longer-key-value|1
+key-0|5
+key-1|5
+key-10|5
+key-11|4
+key-12|5
+key-2|4
+key-3|5
+key-4|4
+key-5|5
+key-6|5
+key-7|5
+key-8|5
+key-9|4
+0|key-0|4
+0|key-1|5
+0|key-10|5
+0|key-11|5
+0|key-12|5
+0|key-2|4
+1 day|2
+2 days|1
+1 mon|1
+|1
+652
+1
+3
+5
+|none|
+60|L60|
+59|L59|
+58|L58|
+46
+47
+48
+49
+-- expected status: 0
@@ -0,0 +1,44 @@
+-- DELETE tombstones every match, compacts the table once and renumbers index row ids; cascaded child rows go in the same pass
+-- setup:
+CREATE TABLE tb (id INT, name TEXT, v FLOAT);
+INSERT INTO tb SELECT n, 'row' || n, n * 0.5 FROM generate_series(1, 20000) AS s(n);
+CREATE INDEX tb_id ON tb (id);
+CREATE INDEX tb_name ON tb (name);
+DELETE FROM tb WHERE id % 7 = 0 OR (id > 15000 AND id <= 16000);
+CREATE TABLE emp (id INT PRIMARY KEY, boss INT REFERENCES emp(id) ON DELETE CASCADE, name TEXT);
+INSERT INTO emp VALUES (1, NULL, 'root'), (2, 1, 'a'), (3, 1, 'b'), (4, 2, 'c'), (5, NULL, 'other'), (6, 5, 'd');
+-- input:
+SELECT COUNT(*), SUM(id), MIN(name), MAX(v) FROM tb;
+SELECT id, name FROM tb WHERE id = 19998;
+SELECT COUNT(*) FROM tb WHERE id = 14;
+SELECT id, v FROM tb WHERE name = 'row16001';
+SELECT COUNT(*) FROM tb WHERE name = 'row15500';
+SELECT COUNT(*) FROM tb WHERE id BETWEEN 14990 AND 16010;
+DELETE FROM tb WHERE id < 19995;
+SELECT id, name FROM tb ORDER BY id;
+SELECT name FROM tb WHERE id = 19997;
+DELETE FROM emp WHERE id = 2 OR id = 3 RETURNING id, name;
+SELECT id, boss, name FROM emp ORDER BY id;
+SELECT name FROM emp WHERE id = 6;
+-- expected output:
+16286|158147143|row1|10000
+19998|row19998
+0
+16001|8000.5
+0
+18
+DELETE 16281
+19995|row19995
+19996|row19996
+19997|row19997
+19998|row19998
+20000|row20000
+row19997
+2|a
+3|b
+DELETE 2
+1||root
+5||other
+6|5|d
+d
+-- expected status: 0
@@ -0,0 +1,46 @@
+-- dictionary-encoded TEXT: filters, grouping, joins and DML on a low-cardinality column, and a column that outgrows its dictionary
+-- setup:
+CREATE TABLE o (id INT, status TEXT, note TEXT);
+INSERT INTO o SELECT n, CASE WHEN n % 3 = 0 THEN 'open' WHEN n % 3 = 1 THEN 'closed' ELSE 'pending' END, 'n' || n FROM generate_series(1, 6000) AS g(n);
+INSERT INTO o VALUES (6001, NULL, NULL);
+CREATE TABLE s (status TEXT, label TEXT);
+INSERT INTO s VALUES ('open', 'O'), ('pending', 'P');
+UPDATE o SET status = 'archived' WHERE id <= 10;
+DELETE FROM o WHERE id BETWEEN 11 AND 20;
+-- input:
+SELECT COUNT(*) FROM o WHERE status = 'open';
+SELECT COUNT(*) FROM o WHERE status <> 'open';
+SELECT COUNT(*) FROM o WHERE status IN ('open', 'archived');
+SELECT COUNT(*) FROM o WHERE status LIKE 'pend%';
+SELECT COUNT(*) FROM o WHERE status BETWEEN 'closed' AND 'open';
+SELECT COUNT(*) FROM o WHERE status = 'archived' OR id > 5999;
+SELECT status, COUNT(*) FROM o GROUP BY status ORDER BY status;
+SELECT DISTINCT status FROM o ORDER BY status;
+SELECT s.label, COUNT(*) FROM o JOIN s ON o.status = s.status GROUP BY s.label ORDER BY s.label;
+SELECT COUNT(*) FROM o WHERE note LIKE 'n1%';
+SELECT id, status, note FROM o WHERE id IN (1, 21, 6000, 6001) ORDER BY id;
+-- expected output:
+1994
+3996
+2004
+1993
+3987
+12
+archived|10
+closed|1993
+open|1994
+pending|1993
+|1
+archived
+closed
+open
+pending
+
+O|1994
+P|1993
+1102
+1|archived|n1
+21|open|n21
+6000|open|n6000
+6001||
+-- expected status: 0
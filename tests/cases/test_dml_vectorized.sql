@@ -0,0 +1,44 @@
+-- UPDATE and DELETE find their rows through the block executor and write SET values column-wise: arithmetic, text and swapped SETs, zone-map filters, NOT NULL checks and compound DELETE predicates
+-- setup:
+CREATE TABLE dv (id INT, region TEXT, price FLOAT, qty INT NOT NULL, a TEXT, b TEXT);
+INSERT INTO dv SELECT n, CASE WHEN n % 3 = 0 THEN 'eu' ELSE 'us' END, n * 2.0, n % 10, 'a' || n, 'b' || n FROM generate_series(1, 5000) AS s(n);
+UPDATE dv SET price = price * 1.5 WHERE region = 'eu';
+UPDATE dv SET a = b, b = a WHERE id > 4990;
+UPDATE dv SET qty = qty + 100, region = UPPER(region) WHERE id BETWEEN 2000 AND 2004;
+-- input:
+SELECT COUNT(*), SUM(price) FROM dv;
+SELECT id, region, price FROM dv WHERE id IN (2, 3, 4998, 4999) ORDER BY id;
+SELECT id, a, b FROM dv WHERE id >= 4989 ORDER BY id LIMIT 4;
+SELECT id, region, qty FROM dv WHERE id BETWEEN 1999 AND 2005 ORDER BY id;
+UPDATE dv SET qty = NULL WHERE id = 10;
+SELECT qty FROM dv WHERE id = 10;
+UPDATE dv SET price = 0 WHERE id > 100000;
+DELETE FROM dv WHERE region = 'us' AND (qty < 5 OR id > 4000);
+SELECT COUNT(*), SUM(id) FROM dv;
+DELETE FROM dv WHERE price > 14990 RETURNING id, region;
+SELECT COUNT(*), MAX(id) FROM dv;
+-- expected output:
+5000|29170833
+2|us|4
+3|eu|9
+4998|eu|14994
+4999|us|9998
+4989|a4989|b4989
+4990|a4990|b4990
+4991|b4991|a4991
+4992|b4992|a4992
+1999|us|9
+2000|US|100
+2001|EU|101
+2002|US|102
+2003|US|103
+2004|EU|104
+2005|us|5
+ERROR:  NOT NULL constraint violated for column 'qty'
+0
+UPDATE 0
+DELETE 1998
+3002|6841168
+4998|eu
+DELETE 1
+3001|4995
@@ -0,0 +1,22 @@
+-- NOT IN / IN subqueries inside a FROM-subquery
+-- setup:
+CREATE TABLE big (id INT, k INT);
+INSERT INTO big SELECT n, n % 1000 FROM generate_series(1, 10000) AS g(n);
+CREATE TABLE sm (k INT);
+INSERT INTO sm SELECT n FROM generate_series(0, 199) AS g(n);
+INSERT INTO sm VALUES (NULL);
+-- input:
+SELECT COUNT(*) FROM (SELECT id FROM big WHERE k NOT IN (SELECT k FROM sm WHERE k < 100)) q;
+SELECT COUNT(*) FROM (SELECT id FROM big WHERE k NOT IN (SELECT k FROM sm WHERE k IS NOT NULL)) q;
+SELECT COUNT(*) FROM (SELECT id FROM big WHERE NOT (k IN (SELECT k FROM sm WHERE k < 500))) q;
+SELECT COUNT(*) FROM (SELECT id FROM big WHERE k NOT IN (SELECT k FROM sm)) q;
+SELECT COUNT(*) FROM (SELECT id FROM big WHERE k IN (SELECT k FROM sm WHERE k < 100)) q;
+SELECT MIN(id), MAX(id) FROM (SELECT id FROM big WHERE k NOT IN (SELECT k FROM sm WHERE k < 999) AND id > 5000) q;
+-- expected output:
+9000
+8000
+8000
+0
+1000
+5200|9999
+-- expected status: 0
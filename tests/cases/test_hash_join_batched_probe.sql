@@ -0,0 +1,36 @@
+-- hash join probe: chain heads resolved per block with duplicate build keys, NULL keys, filtered probes and LEFT JOIN
+-- setup:
+CREATE TABLE d (id INT, grp TEXT);
+INSERT INTO d SELECT n, 'g' || (n % 3) FROM generate_series(1, 5000) AS g(n);
+INSERT INTO d SELECT n, 'dup' FROM generate_series(1, 40) AS g(n);
+INSERT INTO d VALUES (NULL, 'null');
+CREATE TABLE f (k INT, x INT);
+INSERT INTO f SELECT (n * 37) % 6000, n FROM generate_series(1, 4000) AS g(n);
+INSERT INTO f VALUES (NULL, -1), (7, -2);
+-- input:
+SELECT COUNT(*) FROM (SELECT f.x FROM f JOIN d ON f.k = d.id) AS s;
+SELECT f.x, d.grp FROM f JOIN d ON f.k = d.id WHERE f.x > 3990 ORDER BY f.x, d.grp;
+SELECT COUNT(*) FROM (SELECT f.x, d.grp FROM f LEFT JOIN d ON f.k = d.id) AS s;
+SELECT f.x, d.grp FROM f LEFT JOIN d ON f.k = d.id WHERE f.x < 0 ORDER BY f.x, d.grp;
+SELECT d.grp, COUNT(*) FROM f JOIN d ON f.k = d.id GROUP BY d.grp ORDER BY d.grp;
+-- expected output:
+3382
+3991|g1
+3992|g2
+3993|g0
+3994|g1
+3995|g2
+3996|g0
+3997|g1
+3998|g2
+3999|g0
+4000|g1
+4031
+-2|dup
+-2|g1
+-1|
+dup|29
+g0|1117
+g1|1119
+g2|1117
+-- expected status: 0
@@ -0,0 +1,54 @@
+-- hash join on composite keys: ON a1 = b1 AND a2 = b2 builds one hash table over both key columns (int widening, TEXT keys, NULL keys, outer joins, join cache reuse)
+-- setup:
+CREATE TABLE orders (tenant_id INT, order_id INT, amount INT);
+INSERT INTO orders SELECT n % 7, n / 7, n FROM generate_series(0, 6999) AS g(n);
+INSERT INTO orders VALUES (NULL, 1, -1), (1, NULL, -2);
+CREATE TABLE items (tenant_id INT, order_id BIGINT, sku TEXT, qty INT);
+INSERT INTO items SELECT n % 5, n / 3, 's' || (n % 11), n FROM generate_series(0, 2999) AS g(n);
+INSERT INTO items VALUES (NULL, 1, 'sn', -1), (1, NULL, 'sn', -2), (9, 9, 'none', -3);
+CREATE TABLE skus (sku TEXT, tenant_id INT, price INT);
+INSERT INTO skus VALUES ('s1', 1, 10), ('s1', 2, 20), ('s2', 1, 30), ('s3', 3, 40), (NULL, 1, 50);
+-- input:
+EXPLAIN SELECT o.amount, i.qty FROM orders o JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id;
+SELECT COUNT(*), SUM(x.amount), SUM(x.qty) FROM (SELECT o.amount, i.qty FROM orders o JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id) AS x;
+SELECT COUNT(*), SUM(x.amount), SUM(x.qty) FROM (SELECT o.amount, i.qty FROM orders o JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id) AS x;
+SELECT COUNT(*), SUM(x.amount) FROM (SELECT o.amount, i.qty FROM orders o JOIN items i ON o.tenant_id = i.tenant_id) AS x;
+SELECT o.amount, i.qty FROM orders o JOIN items i ON i.order_id = o.order_id AND i.tenant_id = o.tenant_id WHERE o.order_id < 3 ORDER BY o.amount, i.qty;
+SELECT COUNT(*) FROM (SELECT o.amount, i.qty FROM orders o LEFT JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id) AS x;
+SELECT i.qty, o.amount FROM items i LEFT JOIN orders o ON i.tenant_id = o.tenant_id AND i.order_id = o.order_id WHERE i.qty < 0 ORDER BY i.qty;
+SELECT COUNT(*) FROM (SELECT o.amount, i.qty FROM orders o RIGHT JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id) AS x;
+SELECT COUNT(*) FROM (SELECT o.amount, i.qty FROM orders o FULL JOIN items i ON o.tenant_id = i.tenant_id AND o.order_id = i.order_id) AS x;
+SELECT i.qty, s.price FROM items i JOIN skus s ON i.sku = s.sku AND i.tenant_id = s.tenant_id WHERE i.qty < 40 ORDER BY i.qty, s.price;
+SELECT s.sku, o.tenant_id, COUNT(*) FROM orders o JOIN skus s ON o.tenant_id = s.tenant_id AND o.order_id = s.price GROUP BY s.sku, o.tenant_id ORDER BY s.sku, o.tenant_id;
+-- expected output:
+Project
+  Hash Join
+    Seq Scan on orders
+    Seq Scan on items
+3000|10495500|4498500
+3000|10495500|4498500
+3001601|10498996298
+0|0
+1|1
+2|2
+7|5
+10|3
+11|4
+15|6
+16|7
+17|8
+7002
+-3|
+-2|
+-1|
+3003
+7005
+1|10
+3|40
+12|20
+s1|1|1
+s1|2|1
+s2|1|1
+s3|3|1
+|1|1
+-- expected status: 0
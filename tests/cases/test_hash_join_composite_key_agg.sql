@@ -0,0 +1,17 @@
+-- aggregates without GROUP BY over a composite-key join
+-- setup:
+CREATE TABLE cka (x INT, y INT);
+CREATE TABLE ckb (x INT, y INT, w INT);
+INSERT INTO cka VALUES (1, 1), (1, 2), (2, 2);
+INSERT INTO ckb VALUES (1, 1, 100), (1, 2, 102), (3, 3, 5);
+-- input:
+SELECT COUNT(*) FROM cka JOIN ckb ON cka.x = ckb.x AND cka.y = ckb.y;
+SELECT SUM(ckb.w) FROM cka JOIN ckb ON cka.x = ckb.x AND cka.y = ckb.y;
+SELECT COUNT(*) FROM cka LEFT JOIN ckb ON cka.x = ckb.x AND cka.y = ckb.y;
+SELECT COUNT(*) FROM cka JOIN ckb ON cka.x = ckb.x;
+-- expected output:
+2
+202
+3
+4
+-- expected status: 0
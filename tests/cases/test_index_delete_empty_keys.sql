@@ -0,0 +1,40 @@
+-- B-tree index stays correct after a DELETE empties most of its keys
+-- setup:
+CREATE TABLE ik (k INT, v INT);
+CREATE INDEX ik_k ON ik (k);
+INSERT INTO ik SELECT n, n * 2 FROM generate_series(1, 5000) AS g(n);
+DELETE FROM ik WHERE k % 100 <> 0;
+-- input:
+SELECT COUNT(*) FROM ik;
+SELECT k, v FROM ik WHERE k BETWEEN 150 AND 450 ORDER BY k;
+SELECT k FROM ik WHERE k > 4700 ORDER BY k DESC;
+SELECT v FROM ik WHERE k = 2500;
+SELECT COUNT(*) FROM ik WHERE k = 2501;
+INSERT INTO ik SELECT n, -n FROM generate_series(2495, 2505) AS g(n);
+SELECT k, v FROM ik WHERE k >= 2498 AND k <= 2502 ORDER BY k, v;
+DELETE FROM ik;
+SELECT COUNT(*) FROM ik WHERE k < 10000;
+INSERT INTO ik VALUES (7, 70);
+SELECT k, v FROM ik WHERE k >= 0;
+-- expected output:
+50
+200|400
+300|600
+400|800
+5000
+4900
+4800
+5000
+0
+INSERT 0 11
+2498|-2498
+2499|-2499
+2500|-2500
+2500|5000
+2501|-2501
+2502|-2502
+DELETE 61
+0
+INSERT 0 1
+7|70
+-- expected status: 0
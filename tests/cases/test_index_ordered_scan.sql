@@ -0,0 +1,38 @@
+-- ORDER BY ... LIMIT served by walking a B-tree index forwards or backwards instead of sorting, with the index's NULL placement (last ascending, first descending) and OFFSET
+-- setup:
+CREATE TABLE ev (account_id INT, ts TIMESTAMP, amount INT);
+CREATE INDEX ev_acct_ts ON ev (account_id, ts);
+INSERT INTO ev SELECT n % 10, '2024-01-01'::TIMESTAMP + n * INTERVAL '1 minute', n FROM generate_series(1, 5000) AS g(n);
+INSERT INTO ev VALUES (7, NULL, -1);
+-- input:
+SELECT amount, ts FROM ev WHERE account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03' ORDER BY ts DESC LIMIT 3;
+SELECT amount FROM ev WHERE account_id = 7 ORDER BY ts DESC LIMIT 3;
+SELECT amount FROM ev WHERE account_id = 7 ORDER BY ts LIMIT 3;
+SELECT amount FROM ev WHERE account_id = 7 ORDER BY ts NULLS FIRST LIMIT 2;
+SELECT amount FROM ev WHERE account_id = 7 ORDER BY account_id, ts LIMIT 2 OFFSET 1;
+SELECT account_id, amount FROM ev ORDER BY account_id DESC, ts DESC LIMIT 3;
+EXPLAIN SELECT amount, ts FROM ev WHERE account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03' ORDER BY ts DESC LIMIT 3;
+EXPLAIN SELECT * FROM ev ORDER BY account_id, ts LIMIT 3;
+-- expected output:
+2877|2024-01-02 23:57:00
+2867|2024-01-02 23:47:00
+2857|2024-01-02 23:37:00
+-1
+4997
+4987
+7
+17
+27
+-1
+7
+17
+27
+9|4999
+9|4989
+9|4979
+Limit (3)
+  Project
+    Index Scan Backward on ev (account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03')
+Limit (3)
+  Index Scan on ev using ev_acct_ts
+-- expected status: 0
@@ -0,0 +1,34 @@
+-- B-tree range scans: equality on a prefix of a composite index plus <, <=, >, >= or BETWEEN on the next column, with NULL keys left out of ranges, rows past one block, leftover predicates still applied, and rows added by INSERT ... SELECT indexed
+-- setup:
+CREATE TABLE ev (account_id INT, ts TIMESTAMP, amount INT);
+INSERT INTO ev VALUES (7, '2024-01-03', 1), (7, NULL, -1), (8, '2024-01-03', 3);
+CREATE INDEX ev_acct_ts ON ev (account_id, ts);
+INSERT INTO ev SELECT n % 10, '2024-01-01'::TIMESTAMP + n * INTERVAL '1 minute', n FROM generate_series(1, 20000) AS g(n);
+-- input:
+SELECT COUNT(*), MIN(amount), MAX(amount) FROM (SELECT amount FROM ev WHERE account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03') q;
+SELECT COUNT(*) FROM (SELECT amount FROM ev WHERE account_id = 7) q;
+SELECT amount FROM ev WHERE account_id = 7 AND ts > '2024-01-14 21:00' ORDER BY amount;
+SELECT amount FROM ev WHERE account_id = 7 AND ts >= '2024-01-14 21:07' AND ts < '2024-01-14 21:37' ORDER BY amount;
+SELECT amount FROM ev WHERE account_id = 7 AND ts <= '2024-01-01 00:20' ORDER BY amount;
+SELECT amount FROM ev WHERE account_id = 7 AND ts < '2024-01-02' AND amount > 1400 ORDER BY amount;
+SELECT amount FROM ev WHERE account_id BETWEEN 8 AND 9 AND amount > 19990 ORDER BY amount;
+SELECT amount FROM ev WHERE account_id = 7 AND ts BETWEEN '2024-02-01' AND '2024-03-01';
+EXPLAIN SELECT amount FROM ev WHERE account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03';
+-- expected output:
+145|1|2877
+2002
+19987
+19997
+19987
+19997
+7
+17
+1407
+1417
+1427
+1437
+19998
+19999
+Project
+  Index Scan on ev (account_id = 7 AND ts BETWEEN '2024-01-02' AND '2024-01-03')
+-- expected status: 0
@@ -0,0 +1,37 @@
+-- a table large enough for its column arrays to be memory-mapped keeps growing after the switch, and a transaction's snapshot copy of it (dictionary and heap TEXT, prefixes, zones) restores it exactly on ROLLBACK
+-- setup:
+CREATE TABLE seg (id INT, grp TEXT, label TEXT, score FLOAT);
+INSERT INTO seg SELECT n, CASE n % 5 WHEN 0 THEN 'g0' WHEN 1 THEN 'g1' WHEN 2 THEN 'g2' WHEN 3 THEN 'g3' ELSE 'g4' END, 'row-' || n, n * 0.25 FROM generate_series(1, 40000) AS s(n);
+INSERT INTO seg SELECT n, CASE n % 5 WHEN 0 THEN 'g0' WHEN 1 THEN 'g1' WHEN 2 THEN 'g2' WHEN 3 THEN 'g3' ELSE 'g4' END, 'row-' || n, n * 0.25 FROM generate_series(40001, 60000) AS s(n);
+-- input:
+BEGIN;
+UPDATE seg SET grp = 'gx', label = NULL WHERE id <= 100;
+DELETE FROM seg WHERE id > 59000;
+INSERT INTO seg VALUES (70000, 'g9', 'extra', 1.0);
+SELECT COUNT(*), COUNT(label), COUNT(DISTINCT grp) FROM seg;
+ROLLBACK;
+SELECT COUNT(*), SUM(id), SUM(score), COUNT(label), MIN(label), MAX(label) FROM seg;
+SELECT grp, COUNT(*) FROM seg GROUP BY grp ORDER BY grp;
+SELECT * FROM seg WHERE id IN (1, 100, 59001, 60000) ORDER BY id;
+INSERT INTO seg VALUES (60001, 'g1', 'row-60001', 0.5);
+SELECT COUNT(*), MAX(id) FROM seg WHERE grp = 'g1' AND label >= 'row-6';
+-- expected output:
+BEGIN
+UPDATE 100
+DELETE 1000
+INSERT 0 1
+59001|58901|7
+ROLLBACK
+60000|1800030000|450007500|60000|row-1|row-9999
+g0|12000
+g1|12000
+g2|12000
+g3|12000
+g4|12000
+1|g1|row-1|0.25
+100|g0|row-100|25
+59001|g1|row-59001|14750.2
+60000|g0|row-60000|15000
+INSERT 0 1
+890|60001
+-- expected status: 0
@@ -0,0 +1,101 @@
+-- merge join: INNER/LEFT/RIGHT/FULL over inputs already ordered on the join key, with duplicate runs, NULL keys and ORDER BY on the key served without a sort; unordered inputs keep the hash join
+-- setup:
+CREATE TABLE orders (id INT, cust INT, amount INT);
+INSERT INTO orders SELECT n, n / 3, n % 100 FROM generate_series(1, 9000) AS g(n);
+INSERT INTO orders VALUES (NULL, NULL, -1);
+CREATE TABLE custs (cid INT, name TEXT);
+INSERT INTO custs SELECT n, 'c' || n FROM generate_series(-5, 9) AS g(n);
+INSERT INTO custs SELECT n / 2, 'c' || (n / 2) || CASE WHEN n % 2 = 1 THEN 'b' ELSE 'a' END FROM generate_series(20, 25) AS g(n);
+INSERT INTO custs SELECT n, 'c' || n FROM generate_series(13, 5000) AS g(n);
+CREATE TABLE lines (oid BIGINT, qty INT);
+INSERT INTO lines SELECT n / 2, n FROM generate_series(0, 10000) AS g(n);
+INSERT INTO lines VALUES (NULL, 0);
+CREATE TABLE shuffled (cid INT, tag TEXT);
+INSERT INTO shuffled SELECT (n * 7919) % 5000, 't' || n FROM generate_series(1, 5000) AS g(n);
+-- input:
+EXPLAIN SELECT o.id, c.name FROM orders o JOIN custs c ON o.cust = c.cid ORDER BY o.cust;
+EXPLAIN SELECT o.id, s.tag FROM orders o JOIN shuffled s ON o.cust = s.cid;
+SELECT COUNT(*) FROM (SELECT o.id, c.name FROM orders o JOIN custs c ON o.cust = c.cid) AS x;
+SELECT o.id, o.cust, c.name FROM orders o JOIN custs c ON o.cust = c.cid ORDER BY o.id LIMIT 8;
+SELECT c.cid, c.name FROM custs c JOIN orders o ON c.cid = o.id ORDER BY c.cid LIMIT 4;
+EXPLAIN SELECT c.cid, c.name FROM custs c JOIN orders o ON c.cid = o.id ORDER BY c.cid LIMIT 4;
+SELECT o.id, c.name FROM orders o JOIN custs c ON o.cust = c.cid WHERE o.cust BETWEEN 10 AND 12 ORDER BY o.id, c.name;
+SELECT COUNT(*), SUM(x.amount) FROM (SELECT o.amount, c.name FROM orders o LEFT JOIN custs c ON o.cust = c.cid) AS x;
+SELECT COUNT(*) FROM (SELECT o.amount, c.name FROM orders o LEFT JOIN custs c ON o.cust = c.cid WHERE c.name IS NULL) AS x;
+SELECT COUNT(*) FROM (SELECT o.id, c.name FROM orders o RIGHT JOIN custs c ON o.cust = c.cid) AS x;
+SELECT c.cid, c.name FROM orders o RIGHT JOIN custs c ON o.cust = c.cid WHERE o.id IS NULL ORDER BY c.cid LIMIT 8;
+SELECT COUNT(*) FROM (SELECT o.id, c.name FROM orders o FULL JOIN custs c ON o.cust = c.cid) AS x;
+SELECT COUNT(*) FROM (SELECT o.id, l.qty FROM orders o JOIN lines l ON o.id = l.oid) AS x;
+SELECT o.id, l.qty FROM orders o JOIN lines l ON o.id = l.oid ORDER BY o.id, l.qty LIMIT 5;
+SELECT COUNT(*) FROM (SELECT o.id, l.qty FROM orders o FULL JOIN lines l ON o.id = l.oid) AS x;
+SELECT c.name, COUNT(*), SUM(o.amount) FROM orders o JOIN custs c ON o.cust = c.cid WHERE c.cid < 3 GROUP BY c.name ORDER BY c.name;
+SELECT COUNT(*) FROM (SELECT o.id, s.tag FROM orders o JOIN shuffled s ON o.cust = s.cid) AS x;
+-- expected output:
+Project
+  Merge Join
+    Seq Scan on orders
+    Seq Scan on custs
+Project
+  Hash Join
+    Seq Scan on orders
+    Seq Scan on shuffled
+9009
+1|0|c0
+2|0|c0
+3|1|c1
+4|1|c1
+5|1|c1
+6|2|c2
+7|2|c2
+8|2|c2
+1|c1
+2|c2
+3|c3
+4|c4
+Limit (4)
+  Project
+    Merge Join
+      Seq Scan on custs
+      Seq Scan on orders
+30|c10a
+30|c10b
+31|c10a
+31|c10b
+32|c10a
+32|c10b
+33|c11a
+33|c11b
+34|c11a
+34|c11b
+35|c11a
+35|c11b
+36|c12a
+36|c12b
+37|c12a
+37|c12b
+38|c12a
+38|c12b
+9010|445805
+1
+11014
+-5|c-5
+-4|c-4
+-3|c-3
+-2|c-2
+-1|c-1
+3001|c3001
+3002|c3002
+3003|c3003
+11015
+9999
+1|2
+1|3
+2|4
+2|5
+3|6
+14003
+c0|2|3
+c1|3|12
+c2|3|21
+9000
+-- expected status: 0
@@ -0,0 +1,17 @@
+-- LEFT and FULL merge joins whose leading keys have no match emit whole blocks of NULL padding with the padded side's column types, so materializing them through a FROM-subquery stays consistent
+-- setup:
+CREATE TABLE l (k INT, v INT);
+CREATE TABLE r2 (k INT, w INT);
+INSERT INTO l SELECT n / 3, n FROM generate_series(0, 14999) AS g(n);
+INSERT INTO r2 SELECT n / 2 + 2000, n FROM generate_series(0, 9999) AS g(n);
+-- input:
+SELECT COUNT(*), COUNT(w), SUM(w) FROM (SELECT l.k, r2.w FROM l LEFT JOIN r2 ON l.k = r2.k) q;
+SELECT COUNT(*), COUNT(k), COUNT(w) FROM (SELECT l.k, r2.w FROM l FULL JOIN r2 ON l.k = r2.k) q;
+SELECT l.k, r2.w FROM l FULL JOIN r2 ON l.k = r2.k WHERE r2.w > 9996;
+-- expected output:
+24000|18000|53991000
+28000|24000|22000
+|9997
+|9998
+|9999
+-- expected status: 0
@@ -0,0 +1,16 @@
+-- OFFSET spanning several blocks (with and without LIMIT) skips every leading block
+-- setup:
+CREATE TABLE lob (id INT);
+INSERT INTO lob SELECT n FROM generate_series(1, 3000) AS g(n);
+-- input:
+SELECT id FROM lob ORDER BY id DESC OFFSET 2997;
+SELECT id FROM lob LIMIT 2 OFFSET 2048;
+SELECT COUNT(*) FROM (SELECT id FROM lob OFFSET 2500) AS s;
+-- expected output:
+3
+2
+1
+2049
+2050
+500
+-- expected status: 0
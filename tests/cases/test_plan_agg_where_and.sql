@@ -10,7 +10,6 @@ a|30
 b|40
 Sort
   HashAggregate
-    Filter: (active = 1)
-      Filter: (amount > 15)
-        Seq Scan on t1
+    Filter: (amount > 15 AND active = 1)
+      Seq Scan on t1
 -- expected status: 0
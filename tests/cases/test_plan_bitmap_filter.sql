@@ -0,0 +1,26 @@
+-- bitmap filter: AND/OR trees of numeric and IS NULL leaves evaluated as row masks
+-- setup:
+CREATE TABLE t_bmf (id INT, a INT, b BIGINT, f FLOAT, s SMALLINT, name TEXT);
+INSERT INTO t_bmf VALUES (1, 5, 100, 1.5, 3, 'alpha'), (2, 15, NULL, 2.5, 7, 'beta'), (3, NULL, 300, NULL, 9, 'gamma'), (4, 25, 400, 4.5, NULL, 'delta'), (5, 35, 500, 5.5, 1, NULL);
+-- input:
+SELECT id FROM t_bmf WHERE a > 10 AND b >= 400 ORDER BY id;
+SELECT id FROM t_bmf WHERE a BETWEEN 10 AND 30 AND f < 5 AND s IS NOT NULL ORDER BY id;
+SELECT id FROM t_bmf WHERE a < 10000000000 AND f > 2 ORDER BY id;
+SELECT id FROM t_bmf WHERE (a = 5 OR b IS NULL) AND id <= 2 ORDER BY id;
+SELECT id FROM t_bmf WHERE a > 20 OR name = 'alpha' ORDER BY id;
+EXPLAIN SELECT id FROM t_bmf WHERE (a = 5 OR b IS NULL) AND id <= 2
+-- expected output:
+4
+5
+2
+2
+4
+5
+1
+2
+1
+4
+5
+Project
+  Filter: ((a = 5 OR b IS NULL) AND id <= 2)
+    Seq Scan on t_bmf
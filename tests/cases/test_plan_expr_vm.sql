@@ -0,0 +1,11 @@
+-- bytecode expression VM: nested arithmetic, CASE, COALESCE, casts and string functions in a projection
+-- setup:
+CREATE TABLE t_evm (id INT, a INT, b INT, f FLOAT, s TEXT, big BIGINT);
+INSERT INTO t_evm VALUES (1, 3, 4, 1.5, 'abc', 10000000000), (2, 10, 0, 2.25, 'Hello', 5), (3, NULL, 7, NULL, NULL, NULL), (4, -5, 20, 0.5, 'xY', -3);
+-- input:
+SELECT id, (a + b) * (a - b) + LENGTH(s), CASE WHEN a > 0 THEN a ELSE f END * 2, COALESCE(a, b, 0) * 10, COALESCE(big, 0) * 2 - a, CAST(COALESCE(a, 0) AS FLOAT) / 4, UPPER(s) || '/' || LOWER(s), CASE WHEN s IS NULL THEN 'none' WHEN LENGTH(s) > 3 THEN UPPER(s) ELSE s END || '.' FROM t_evm ORDER BY id;
+-- expected output:
+1|-4|6|30|19999999997|0.75|ABC/abc|abc.
+2|105|20|100|0|2.5|HELLO/hello|HELLO.
+3|||70||0||none.
+4|-373|1|-50|-1|-1.25|XY/xy|xY.
@@ -0,0 +1,12 @@
+-- bytecode expression VM: CASE only evaluates the rows that reach each branch
+-- setup:
+CREATE TABLE t_evmz (id INT, a INT, b INT);
+INSERT INTO t_evmz VALUES (1, 7, 2), (2, 10, 0), (3, NULL, 5);
+-- input:
+SELECT id, COALESCE(CASE WHEN b = 0 THEN NULL ELSE a / b END, -1) FROM t_evmz ORDER BY id;
+SELECT id, COALESCE(a / b, 0) FROM t_evmz ORDER BY id;
+-- expected output:
+1|3
+2|-1
+3|-1
+ERROR:  division by zero
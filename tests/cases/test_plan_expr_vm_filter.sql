@@ -0,0 +1,21 @@
+-- bytecode expression VM: WHERE clauses with expression operands, column-to-column compares and NOT
+-- setup:
+CREATE TABLE t_evmf (id INT, a INT, b INT, f FLOAT, s TEXT);
+INSERT INTO t_evmf VALUES (1, 3, 4, 1.5, 'abc'), (2, 10, 0, 2.25, 'Hello'), (3, NULL, 7, NULL, NULL), (4, -5, 20, 0.5, 'xY');
+-- input:
+SELECT id FROM t_evmf WHERE a + b > 10 ORDER BY id;
+SELECT id FROM t_evmf WHERE a < b ORDER BY id;
+SELECT id FROM t_evmf WHERE NOT (a > 0 AND s LIKE '%l%') ORDER BY id;
+SELECT id, COALESCE(a, b, 0) * 10 FROM t_evmf WHERE a * 2 < b OR f IS NULL ORDER BY id;
+EXPLAIN SELECT id FROM t_evmf WHERE a + b > 10
+-- expected output:
+4
+1
+4
+1
+4
+3|70
+4|-50
+Project
+  Filter (bytecode)
+    Seq Scan on t_evmf
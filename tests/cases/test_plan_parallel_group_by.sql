@@ -0,0 +1,23 @@
+-- plan: large integer GROUP BY (partitioned parallel aggregation when workers > 1) matches serial results and group order
+-- setup:
+CREATE TABLE pg (id INT, k BIGINT, grp SMALLINT, v INT);
+INSERT INTO pg SELECT n, (n * 7919) % 5003, n % 7, n % 100 - 50 FROM generate_series(1, 100000) AS g(n);
+INSERT INTO pg VALUES (100001, NULL, NULL, 5);
+-- input:
+SELECT grp, COUNT(*), SUM(v), MIN(id), MAX(id) FROM pg WHERE id > 10 GROUP BY grp;
+SELECT k, COUNT(*), SUM(v), AVG(v) FROM pg GROUP BY k ORDER BY k DESC LIMIT 3;
+SELECT COUNT(*), SUM(c) FROM (SELECT k, COUNT(*) AS c FROM pg GROUP BY k) AS sub;
+-- expected output:
+4|14285|-7125|11|99999
+5|14285|-7140|12|100000
+6|14284|-7106|13|99994
+0|14284|-7022|14|99995
+1|14284|-7038|15|99996
+2|14284|-7054|16|99997
+3|14284|-7070|17|99998
+|1|5|100001|100001
+|1|5|5
+5002|20|130|6.5
+5001|20|90|4.5
+5004|100001
+-- expected status: 0
@@ -0,0 +1,29 @@
+-- plan: large hash joins (radix-partitioned build, parallel probe when workers > 1) match serial results, including keys whose matches span several output blocks
+-- setup:
+CREATE TABLE hjo (id INT, cid INT, amt INT);
+INSERT INTO hjo SELECT n, (n * 31) % 60000, n % 1000 FROM generate_series(1, 100000) AS g(n);
+CREATE TABLE hjc (cid INT, name TEXT, tier INT);
+INSERT INTO hjc SELECT n, 'c' || n, n % 5 FROM generate_series(1, 40000) AS g(n);
+INSERT INTO hjc SELECT 7, 'd' || n, 9 FROM generate_series(1, 3000) AS g(n);
+-- input:
+SELECT hjc.tier, COUNT(*), SUM(hjo.amt), MIN(hjo.id), MAX(hjo.id) FROM hjo JOIN hjc ON hjo.cid = hjc.cid GROUP BY hjc.tier ORDER BY hjc.tier;
+SELECT hjo.id, hjc.name FROM hjo JOIN hjc ON hjo.cid = hjc.cid WHERE hjo.amt < 500 ORDER BY hjo.id DESC LIMIT 3;
+SELECT COUNT(*), SUM(id) FROM (SELECT hjo.id, hjc.name FROM hjo JOIN hjc ON hjo.cid = hjc.cid WHERE hjc.tier = 9) AS s;
+SELECT COUNT(*) FROM (SELECT hjo.id, hjc.name FROM hjo LEFT JOIN hjc ON hjo.cid = hjc.cid) AS s;
+SELECT hjo.id, hjc.name FROM hjo LEFT JOIN hjc ON hjo.cid = hjc.cid WHERE hjo.id < 30000 AND hjc.name IS NULL ORDER BY hjo.id LIMIT 3;
+-- expected output:
+0|13420|6675000|5|100000
+1|13420|6689000|1|99996
+2|13420|6703000|2|99997
+3|13420|6717000|3|99998
+4|13420|6731000|4|99999
+9|6000|582000|27097|87097
+100000|c40000
+99499|c24469
+99498|c24438
+6000|342582000
+106000
+1291|
+1292|
+1293|
+-- expected status: 0
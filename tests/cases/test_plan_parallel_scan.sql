@@ -0,0 +1,24 @@
+-- plan: large scan + filter + projection (morsel-parallel when workers > 1) keeps serial row order
+-- setup:
+CREATE TABLE ps (id INT, grp INT, name TEXT);
+INSERT INTO ps SELECT n, n % 97, 'n' || n FROM generate_series(1, 100000) AS g(n);
+-- input:
+SELECT id, grp * 2 FROM ps WHERE grp = 96 AND id > 99000;
+SELECT name FROM ps WHERE grp = 5 OR id = 77777 ORDER BY id DESC LIMIT 3;
+SELECT COUNT(*) FROM (SELECT id, grp + 1 FROM ps WHERE grp > 90) AS sub;
+-- expected output:
+99036|192
+99133|192
+99230|192
+99327|192
+99424|192
+99521|192
+99618|192
+99715|192
+99812|192
+99909|192
+n99915
+n99818
+n99721
+6180
+-- expected status: 0
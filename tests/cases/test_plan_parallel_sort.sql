@@ -0,0 +1,37 @@
+-- plan: large ORDER BY (parallel run sort + k-way merge when workers > 1) matches serial order for radix, composite and comparator sorts
+-- setup:
+CREATE TABLE ps (id INT, k INT, b BIGINT, f FLOAT, t TEXT, s SMALLINT);
+INSERT INTO ps SELECT n, (n * 7919) % 1000, (n * 613) % 100003, ((n * 37) % 1000) / 8.0, 'v' || ((n * 13) % 5000), n % 100 FROM generate_series(1, 100000) AS g(n);
+INSERT INTO ps VALUES (100001, NULL, NULL, NULL, NULL, NULL);
+-- input:
+SELECT k, id FROM ps ORDER BY k DESC, id OFFSET 99997;
+SELECT id, k FROM ps ORDER BY k, id OFFSET 99998;
+SELECT b FROM ps ORDER BY b DESC OFFSET 99998;
+SELECT f FROM ps ORDER BY f OFFSET 99998;
+SELECT t FROM ps ORDER BY t DESC OFFSET 99997;
+SELECT s, t FROM ps ORDER BY s DESC, t OFFSET 99998;
+SELECT id FROM ps ORDER BY t, id DESC OFFSET 99999;
+-- expected output:
+0|97000
+0|98000
+0|99000
+0|100000
+98321|999
+99321|999
+100001|
+3
+2
+1
+124.875
+124.875
+
+v0
+v0
+v0
+v0
+0|v900
+0|v900
+0|v900
+3923
+100001
+-- expected status: 0
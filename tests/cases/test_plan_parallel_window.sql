@@ -0,0 +1,33 @@
+-- plan: window functions over many partitions (parallel sort + per-partition evaluation when workers > 1) match serial results
+-- setup:
+CREATE TABLE pw (id INT, dev INT, ts BIGINT, v FLOAT, s INT);
+INSERT INTO pw SELECT n, (n * 7919) % 997, (n * 613) % 100003, (n * 37) % 1000, n % 7 FROM generate_series(1, 60000) AS g(n);
+INSERT INTO pw VALUES (60001, NULL, 5, 1.5, NULL);
+-- input:
+SELECT id, dev, ts, ROW_NUMBER() OVER (PARTITION BY dev ORDER BY ts) FROM pw ORDER BY id LIMIT 4;
+SELECT id, RANK() OVER (PARTITION BY dev ORDER BY v), SUM(v) OVER (PARTITION BY dev), LAG(ts) OVER (PARTITION BY dev ORDER BY ts) FROM pw ORDER BY id DESC LIMIT 3;
+SELECT id, AVG(v) OVER (PARTITION BY dev ORDER BY ts ROWS BETWEEN 2 PRECEDING AND 2 FOLLOWING) FROM pw ORDER BY id LIMIT 3;
+SELECT id, COUNT(*) OVER (PARTITION BY dev ORDER BY ts GROUPS BETWEEN 1 PRECEDING AND CURRENT ROW) FROM pw ORDER BY id LIMIT 3;
+SELECT id, ROW_NUMBER() OVER (PARTITION BY dev ORDER BY ts), ROW_NUMBER() OVER (PARTITION BY s ORDER BY ts) FROM pw ORDER BY id LIMIT 3;
+SELECT dev, ts, ROW_NUMBER() OVER (PARTITION BY dev ORDER BY ts DESC) FROM pw LIMIT 3 OFFSET 30000;
+-- expected output:
+1|940|613|1
+2|883|1226|1
+3|826|1839|1
+4|769|2452|1
+60001|1|1.5|
+60000|1|32130|
+59999|61|30873|78002
+1|38
+2|75
+3|112
+1|1
+2|1
+3|1
+1|1|54
+2|1|105
+3|1|158
+498|39721|36
+498|39437|37
+498|39153|38
+-- expected status: 0
@@ -30,7 +30,7 @@ ORDER BY i.id;
 Project
   Sort
     Hash Join
-      Filter: ( = 0)
+      Filter: (i.category = 'electronics' OR i.category = 'books')
         Seq Scan on pd_or_items
       Seq Scan on pd_or_stock
 
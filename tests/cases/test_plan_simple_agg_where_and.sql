@@ -8,7 +8,6 @@ EXPLAIN SELECT SUM(val) FROM t1 WHERE val > 15 AND active = 1
 -- expected output:
 70
 Aggregate
-  Filter: (active = 1)
-    Filter: (val > 15)
-      Seq Scan on t1
+  Filter: (val > 15 AND active = 1)
+    Seq Scan on t1
 -- expected status: 0
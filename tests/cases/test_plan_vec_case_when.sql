@@ -0,0 +1,12 @@
+-- vectorized CASE WHEN: bucketing with column-expression branches, NULL first branch, mixed INT/FLOAT branches
+-- setup:
+CREATE TABLE t_vcase (id INT, amount INT, b INT, f FLOAT, s TEXT);
+INSERT INTO t_vcase VALUES (1, 3, 4, 1.5, 'abc'), (2, 10, 0, 2.25, 'Hello'), (3, NULL, 7, NULL, NULL), (4, -5, 20, 0.5, 'xY'), (5, 25, 5, 3.0, 'abc');
+-- input:
+SELECT id, CASE WHEN amount < 0 THEN 'neg' WHEN amount < 10 THEN 'small' WHEN amount IS NULL THEN NULL ELSE 'big' END, CASE WHEN b = 0 THEN NULL ELSE amount / b END, CASE WHEN amount > 0 THEN amount ELSE f END, CASE s WHEN 'abc' THEN amount * 2 WHEN 'xY' THEN b + 1 END FROM t_vcase ORDER BY id;
+-- expected output:
+1|small|0|3|6
+2|big||10|
+3||||
+4|neg|0|0.5|21
+5|big|5|25|50
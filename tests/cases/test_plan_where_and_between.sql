@@ -8,8 +8,7 @@ EXPLAIN SELECT id FROM t1 WHERE val BETWEEN 10 AND 30 AND active = 1 ORDER BY id
 -- expected output:
 2
 Project
-  Sort
-    Filter: (active = 1)
-      Filter: (val BETWEEN 10)
-        Seq Scan on t1
+  Sort (id)
+    Filter: (val BETWEEN 10 AND 30 AND active = 1)
+      Seq Scan on t1
 -- expected status: 0
@@ -8,8 +8,7 @@ EXPLAIN SELECT id FROM t1 WHERE val IS NOT NULL AND name IS NOT NULL ORDER BY id
 -- expected output:
 1
 Project
-  Sort
-    Filter: (name IS NOT NULL 0)
-      Filter: (val IS NOT NULL 0)
-        Seq Scan on t1
+  Sort (id)
+    Filter: (val IS NOT NULL AND name IS NOT NULL)
+      Seq Scan on t1
 -- expected status: 0
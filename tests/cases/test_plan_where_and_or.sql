@@ -9,8 +9,7 @@ EXPLAIN SELECT name FROM t1 WHERE active = 1 AND (val = 10 OR val = 30) ORDER BY
 alice
 charlie
 Project
-  Sort
-    Filter: ( = 0)
-      Filter: (active = 1)
-        Seq Scan on t1
+  Sort (name)
+    Filter: (active = 1 AND (val = 10 OR val = 30))
+      Seq Scan on t1
 -- expected status: 0
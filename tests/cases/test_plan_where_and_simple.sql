@@ -10,8 +10,7 @@ EXPLAIN SELECT id, val FROM t1 WHERE val >= 20 AND val <= 40 ORDER BY id
 3|30
 4|40
 Project
-  Sort
-    Filter: (val <= 40)
-      Filter: (val >= 20)
-        Seq Scan on t1
+  Sort (id)
+    Filter: (val >= 20 AND val <= 40)
+      Seq Scan on t1
 -- expected status: 0
@@ -9,9 +9,7 @@ EXPLAIN SELECT id FROM t1 WHERE a >= 20 AND a <= 30 AND b > 100 ORDER BY id
 2
 3
 Project
-  Sort
-    Filter: (b > 100)
-      Filter: (a <= 30)
-        Filter: (a >= 20)
-          Seq Scan on t1
+  Sort (id)
+    Filter: ((a >= 20 AND a <= 30) AND b > 100)
+      Seq Scan on t1
 -- expected status: 0
@@ -10,6 +10,6 @@ alice
 charlie
 Project
   Sort (name)
-    Filter: ( = 0)
+    Filter: (val = 10 OR val = 30)
       Seq Scan on t1
 -- expected status: 0
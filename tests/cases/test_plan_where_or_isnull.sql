@@ -11,6 +11,6 @@ charlie
 dave
 Project
   Sort (name)
-    Filter: ( = 0)
+    Filter: (val IS NULL OR val > 20)
       Seq Scan on t1
 -- expected status: 0
@@ -11,6 +11,6 @@ charlie|30
 dave|40
 Project
   Sort (id)
-    Filter: ( = 0)
+    Filter: (id = 1 OR val >= 30)
       Seq Scan on t1
 -- expected status: 0
@@ -10,6 +10,6 @@ EXPLAIN SELECT val FROM t1 WHERE name = 'alice' OR name = 'dave' ORDER BY val
 40
 Project
   Sort (val)
-    Filter: ( = 0)
+    Filter: (name = 'alice' OR name = 'dave')
       Seq Scan on t1
 -- expected status: 0
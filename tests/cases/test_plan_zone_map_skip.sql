@@ -0,0 +1,14 @@
+-- plan: zone maps skip blocks of a multi-block table and stay correct after UPDATE / DELETE
+-- setup:
+CREATE TABLE ev (id INT, b BIGINT, d DATE);
+INSERT INTO ev SELECT n, CASE WHEN n % 1000 = 0 THEN NULL ELSE n END, CAST('2026-01-01' AS DATE) FROM generate_series(1, 4096) AS g(n);
+INSERT INTO ev SELECT n, CASE WHEN n % 1000 = 0 THEN NULL ELSE n END, CAST('2026-10-01' AS DATE) FROM generate_series(4097, 5000) AS g(n);
+UPDATE ev SET id = 99999 WHERE id = 3;
+DELETE FROM ev WHERE id < 2048;
+-- input:
+SELECT COUNT(*), MIN(id), MAX(id) FROM ev WHERE id >= 4990 AND id < 99999;
+SELECT id FROM ev WHERE id > 9000;
+SELECT id FROM ev WHERE id BETWEEN 2047 AND 2050 AND b > 0 ORDER BY id;
+SELECT COUNT(*) FROM ev WHERE b IS NULL;
+SELECT COUNT(*), MIN(id) FROM ev WHERE d >= '2026-09-01';
+SELECT COUNT(*) FROM ev WHERE d BETWEEN '2026-01-01' AND '2026-01-31';
@@ -0,0 +1,45 @@
+-- runtime join filters: build-side Bloom / min-max filters pushed into probe scans for INNER and RIGHT joins; LEFT joins, empty build sides, NULL keys and mixed key types
+-- setup:
+CREATE TABLE dim (id INT, name TEXT, region TEXT);
+INSERT INTO dim SELECT n, 'd' || n, CASE WHEN n % 50 = 0 THEN 'east' ELSE 'west' END FROM generate_series(1, 2000) AS g(n);
+CREATE TABLE fact (dim_id INT, amount INT, tag TEXT);
+INSERT INTO fact SELECT (n * 13) % 2100, n, 't' || (n % 7) FROM generate_series(1, 30000) AS g(n);
+INSERT INTO fact VALUES (NULL, -1, 'null');
+CREATE TABLE big (dim_id BIGINT, v INT);
+INSERT INTO big SELECT n % 2500, n FROM generate_series(1, 5000) AS g(n);
+CREATE TABLE empty_dim (id INT, name TEXT);
+-- input:
+SELECT COUNT(*), SUM(f.amount) FROM (SELECT f.amount FROM fact f JOIN dim d ON f.dim_id = d.id WHERE d.region = 'east') AS f;
+SELECT d.region, COUNT(*) FROM fact f JOIN dim d ON f.dim_id = d.id WHERE d.region = 'east' GROUP BY d.region;
+SELECT f.tag, COUNT(*) FROM fact f JOIN dim d ON f.dim_id = d.id WHERE d.id BETWEEN 100 AND 120 GROUP BY f.tag ORDER BY f.tag;
+SELECT COUNT(*) FROM (SELECT d.name, f.amount FROM fact f RIGHT JOIN dim d ON f.dim_id = d.id WHERE d.region = 'east') AS x;
+SELECT COUNT(*) FROM (SELECT f.amount, d.name FROM fact f LEFT JOIN dim d ON f.dim_id = d.id) AS x;
+SELECT COUNT(*) FROM (SELECT f.amount FROM fact f JOIN empty_dim n ON f.dim_id = n.id) AS x;
+SELECT b.v, d.name FROM big b JOIN dim d ON b.dim_id = d.id WHERE d.id > 1995 ORDER BY b.v;
+SELECT f.tag, d.name FROM fact f JOIN dim d ON f.tag = d.name ORDER BY f.tag;
+SELECT COUNT(*) FROM (SELECT f.tag FROM fact f JOIN (SELECT 't' || n AS t FROM generate_series(2, 3) AS g(n)) s ON f.tag = s.t) AS x;
+-- expected output:
+572|8583100
+east|572
+t0|42
+t1|43
+t2|45
+t3|44
+t4|42
+t5|42
+t6|42
+572
+30001
+0
+1996|d1996
+1997|d1997
+1998|d1998
+1999|d1999
+2000|d2000
+4496|d1996
+4497|d1997
+4498|d1998
+4499|d1999
+4500|d2000
+8572
+-- expected status: 0
@@ -0,0 +1,28 @@
+-- ORDER BY and partitioned window functions merge sorted runs spilled past SET work_mem and return the same rows
+-- setup:
+CREATE TABLE big (id INT, g INT, name TEXT);
+INSERT INTO big SELECT n, n % 37, 'name_' || ((n * 7919) % 30011) FROM generate_series(1, 30000) AS t(n);
+INSERT INTO big VALUES (30001, NULL, NULL);
+SET work_mem = '64kB';
+-- input:
+SELECT id, name FROM big ORDER BY name DESC, id LIMIT 3 OFFSET 29995;
+SELECT id, g, name FROM big ORDER BY g NULLS FIRST, id DESC LIMIT 4;
+SELECT g, id, ROW_NUMBER() OVER (PARTITION BY g ORDER BY id DESC) FROM big LIMIT 3 OFFSET 29998;
+SELECT g, id, SUM(id) OVER (PARTITION BY g ORDER BY id), COUNT(*) OVER (PARTITION BY g) FROM big ORDER BY id LIMIT 3;
+RESET work_mem;
+-- expected output:
+20500|name_10001
+13182|name_10000
+25327|name_1000
+30001||
+29970|0|name_5442
+29933|0|name_12549
+29896|0|name_19656
+36|73|809
+36|36|810
+|30001|1
+1|1|1|811
+2|2|2|811
+3|3|3|811
+SET
+-- expected status: 0
@@ -0,0 +1,74 @@
+-- TEXT prefixes: equality, ordering, LIKE, GROUP BY, ORDER BY and joins on values sharing long prefixes, 8/9-byte boundaries, empty strings and NULLs
+-- setup:
+CREATE TABLE c (id INT, name TEXT, code TEXT);
+INSERT INTO c SELECT n, 'customer-' || (n % 5000), CASE WHEN n % 4 = 0 THEN 'abcdefgh' WHEN n % 4 = 1 THEN 'abcdefghi' WHEN n % 4 = 2 THEN 'abcdefg' ELSE '' END FROM generate_series(1, 6000) AS g(n);
+INSERT INTO c VALUES (6001, NULL, NULL), (6002, 'customer', 'abcdefgh' || 'z'), (6003, 'Customer-1', 'b');
+CREATE TABLE o (cust TEXT, amt INT);
+INSERT INTO o SELECT 'customer-' || (n * 7 % 5000), n FROM generate_series(1, 300) AS g(n);
+INSERT INTO o VALUES ('customer', 1000), ('customer-', 1), (NULL, 5);
+-- input:
+SELECT COUNT(*) FROM c WHERE name = 'customer-42';
+SELECT COUNT(*) FROM c WHERE name <> 'customer-42';
+SELECT COUNT(*) FROM c WHERE name < 'customer-1';
+SELECT COUNT(*) FROM c WHERE name >= 'customer-4999';
+SELECT COUNT(*) FROM c WHERE name LIKE 'customer-49%';
+SELECT COUNT(*) FROM c WHERE name LIKE 'cust%';
+SELECT COUNT(*) FROM c WHERE name LIKE 'customer-1_';
+SELECT COUNT(*) FROM c WHERE name LIKE 'Cust%';
+SELECT COUNT(*) FROM c WHERE name ILIKE 'cust%';
+SELECT code, COUNT(*) FROM c GROUP BY code ORDER BY code;
+SELECT COUNT(*) FROM c WHERE code = 'abcdefgh';
+SELECT COUNT(*) FROM c WHERE code > 'abcdefgh';
+SELECT COUNT(*) FROM c WHERE code LIKE 'abcdefgh%';
+SELECT COUNT(*) FROM c WHERE code LIKE 'abcdefg%' AND id > 100;
+SELECT name FROM c ORDER BY name LIMIT 4;
+SELECT name FROM c WHERE id > 5990 ORDER BY name DESC;
+SELECT id, name FROM c ORDER BY name, id LIMIT 3 OFFSET 2;
+SELECT o.cust, COUNT(*) FROM o JOIN c ON o.cust = c.name WHERE o.amt >= 299 GROUP BY o.cust ORDER BY o.cust;
+SELECT COUNT(DISTINCT name) FROM c;
+-- expected output:
+2
+6000
+3
+1111
+122
+6001
+20
+1
+6002
+|1500
+abcdefg|1500
+abcdefgh|1500
+abcdefghi|1500
+abcdefghz|1
+b|1
+|1
+1500
+1502
+3001
+4426
+Customer-1
+customer
+customer-0
+customer-1
+
+customer-999
+customer-998
+customer-997
+customer-996
+customer-995
+customer-994
+customer-993
+customer-992
+customer-991
+customer-1000
+customer
+Customer-1
+5000|customer-0
+1|customer-1
+5001|customer-1
+customer|1
+customer-2093|1
+customer-2100|1
+5002
+-- expected status: 0
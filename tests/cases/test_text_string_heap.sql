@@ -0,0 +1,30 @@
+-- TEXT values in the table string heap: repeated UPDATEs and DELETEs of a high-cardinality column, then NULLs and reads back
+-- setup:
+CREATE TABLE h (id INT, body TEXT, tag TEXT);
+INSERT INTO h SELECT n, 'v0-' || n || '-' || REPEAT('x', 200), 't' || n FROM generate_series(1, 8000) AS g(n);
+UPDATE h SET body = 'v1-' || id || '-' || REPEAT('y', 200);
+UPDATE h SET body = 'v2-' || id || '-' || REPEAT('z', 200) WHERE id % 2 = 0;
+DELETE FROM h WHERE id % 5 = 0;
+UPDATE h SET tag = NULL WHERE id % 7 = 0;
+UPDATE h SET body = 'short' || id WHERE id > 7990;
+-- input:
+SELECT COUNT(*) FROM h;
+SELECT COUNT(*) FROM h WHERE body LIKE 'v1-%';
+SELECT COUNT(*) FROM h WHERE body LIKE 'v2-%';
+SELECT COUNT(*) FROM h WHERE tag IS NULL;
+SELECT SUM(LENGTH(body)) FROM h WHERE id <= 100;
+SELECT id, SUBSTRING(body, 1, 8), tag FROM h WHERE id IN (1, 2, 7, 10, 7991, 7998) ORDER BY id;
+SELECT COUNT(DISTINCT tag) FROM h;
+-- expected output:
+6400
+3196
+3196
+914
+16472
+1|v1-1-yyy|t1
+2|v2-2-zzz|t2
+7|v1-7-yyy|
+7991|short799|t7991
+7998|short799|t7998
+5486
+-- expected status: 0
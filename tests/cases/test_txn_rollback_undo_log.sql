@@ -0,0 +1,46 @@
+-- ROLLBACK replays the transaction's row log: inserts, vectorized and row-wise updates, deletes (including of rows inserted in the same transaction) and a nested transaction committed into its parent are all undone, indexes and SERIAL counters included
+-- setup:
+CREATE TABLE ul (id SERIAL PRIMARY KEY, name TEXT, v FLOAT, tag TEXT);
+INSERT INTO ul (name, v, tag) SELECT 'n' || n, n * 1.5, CASE WHEN n % 2 = 0 THEN 'even' ELSE NULL END FROM generate_series(1, 1000) AS g(n);
+CREATE INDEX ul_name ON ul (name);
+-- input:
+BEGIN;
+INSERT INTO ul (name, v, tag) VALUES ('x1', 1, 'new'), ('x2', 2, NULL);
+UPDATE ul SET v = -1, tag = 'upd' WHERE id <= 10;
+DELETE FROM ul WHERE id % 3 = 0;
+UPDATE ul SET name = 'renamed' WHERE id = 500;
+BEGIN;
+INSERT INTO ul (name, v, tag) VALUES ('x3', 3, 'new');
+DELETE FROM ul WHERE tag = 'new';
+COMMIT;
+SELECT COUNT(*), SUM(v), COUNT(tag) FROM ul;
+ROLLBACK;
+SELECT COUNT(*), SUM(v), COUNT(tag), MIN(name), MAX(name) FROM ul;
+SELECT id, name, v, tag FROM ul WHERE id IN (1, 3, 10, 500, 999) ORDER BY id;
+SELECT id FROM ul WHERE name = 'n500';
+SELECT COUNT(*) FROM ul WHERE name = 'renamed';
+INSERT INTO ul (name) VALUES ('after');
+SELECT id, name FROM ul WHERE name = 'after';
+-- expected output:
+BEGIN
+INSERT 0 2
+UPDATE 10
+DELETE 334
+UPDATE 1
+BEGIN
+INSERT 0 1
+DELETE 2
+COMMIT
+667|500445|337
+ROLLBACK
+1000|750750|500|n1|n999
+1|n1|1.5|
+3|n3|4.5|
+10|n10|15|even
+500|n500|750|even
+999|n999|1498.5|
+500
+0
+INSERT 0 1
+1001|after
+-- expected status: 0
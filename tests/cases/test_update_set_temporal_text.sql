@@ -0,0 +1,17 @@
+-- UPDATE SET with a text literal on DATE / TIMESTAMP / TIME columns parses the literal
+-- setup:
+CREATE TABLE ev (id INT, d DATE, ts TIMESTAMP, t TIME);
+INSERT INTO ev VALUES (1, NULL, NULL, NULL), (2, '2020-01-01', NULL, NULL);
+CREATE TABLE evc (id INT CHECK (id > 0), d DATE);
+INSERT INTO evc VALUES (1, NULL), (2, NULL);
+UPDATE ev SET d = '2025-01-01', ts = '2025-02-03 04:05:06', t = '07:08:09';
+UPDATE evc SET d = '2024-12-31' WHERE id = 2;
+-- input:
+SELECT id, d, ts, t FROM ev ORDER BY id;
+SELECT id, d FROM evc ORDER BY id;
+-- expected output:
+1|2025-01-01|2025-02-03 04:05:06|07:08:09
+2|2025-01-01|2025-02-03 04:05:06|07:08:09
+1|
+2|2024-12-31
+-- expected status: 0
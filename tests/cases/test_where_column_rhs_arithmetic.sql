@@ -0,0 +1,32 @@
+-- column compared with an arithmetic expression over another column
+-- setup:
+CREATE TABLE ra (a INT, b INT);
+INSERT INTO ra VALUES (2, 1), (5, 5), (3, 1), (10, 9), (NULL, 1), (4, NULL);
+CREATE TABLE rb (x INT);
+INSERT INTO rb VALUES (2), (6);
+-- input:
+SELECT a, b FROM ra WHERE a = b + 1 ORDER BY a;
+SELECT a, b FROM ra WHERE a > b * 2 ORDER BY a;
+SELECT a, b FROM ra WHERE a <> b + 1 ORDER BY a;
+SELECT COUNT(*) FROM ra WHERE a > b / 1000000000;
+SELECT a, b FROM ra WHERE ra.a >= ra.b * 2 AND b > 0 ORDER BY a;
+SELECT a, b FROM ra WHERE a - 1 = b - 0 ORDER BY a;
+SELECT a, b FROM ra WHERE NOT (a < b + 2) ORDER BY a;
+SELECT ra.a, rb.x FROM ra JOIN rb ON rb.x = ra.b + 1 ORDER BY ra.a;
+-- expected output:
+2|1
+10|9
+3|1
+3|1
+5|5
+4
+2|1
+3|1
+2|1
+10|9
+3|1
+2|2
+3|2
+5|6
+|2
+-- expected status: 0
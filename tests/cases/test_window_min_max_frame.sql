@@ -0,0 +1,38 @@
+-- window MIN/MAX over sliding ROWS frames (segment tree), EXCLUDE CURRENT ROW, whole partition, and RANGE value offsets
+-- setup:
+CREATE TABLE wm (id INT, g TEXT, v INT, s TEXT);
+INSERT INTO wm VALUES (1, 'a', 5, 'p'), (2, 'a', 3, 'q'), (3, 'a', 8, NULL), (4, 'a', NULL, 'b'), (5, 'a', 6, 'z'), (6, 'b', 2, 'm'), (7, 'b', 9, 'c');
+-- input:
+SELECT id, MIN(v) OVER (PARTITION BY g ORDER BY id ROWS BETWEEN 1 PRECEDING AND 1 FOLLOWING) FROM wm ORDER BY id;
+SELECT id, MAX(s) OVER (PARTITION BY g ORDER BY id ROWS BETWEEN 1 PRECEDING AND 1 FOLLOWING EXCLUDE CURRENT ROW) FROM wm ORDER BY id;
+SELECT id, MAX(v) OVER (PARTITION BY g) FROM wm ORDER BY id;
+SELECT id, SUM(v) OVER (ORDER BY v RANGE BETWEEN 2 PRECEDING AND 1 FOLLOWING) FROM wm WHERE id <> 4 ORDER BY id;
+-- expected output:
+1|3
+2|3
+3|3
+4|6
+5|6
+6|2
+7|2
+1|q
+2|p
+3|q
+4|z
+5|b
+6|c
+7|m
+1|8
+2|8
+3|8
+4|8
+5|8
+6|9
+7|9
+1|14
+2|5
+3|23
+5|11
+6|5
+7|17
+-- expected status: 0
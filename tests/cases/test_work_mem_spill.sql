@@ -0,0 +1,40 @@
+-- hash join, semi join and hash aggregate spill to temporary files past SET work_mem and return the same rows
+-- setup:
+CREATE TABLE big (id INT, g INT, v TEXT);
+INSERT INTO big SELECT n, n % 3000, 'v' || n FROM generate_series(1, 30000) AS s(n);
+INSERT INTO big VALUES (NULL, NULL, 'vnull');
+CREATE TABLE probe (id INT, tag TEXT);
+INSERT INTO probe VALUES (7, 'seven'), (29999, 'late'), (15000, 'mid'), (40000, 'missing'), (NULL, 'null');
+SET work_mem = '64kB';
+-- input:
+SHOW work_mem;
+SELECT p.tag, b.v FROM probe p JOIN big b ON p.id = b.id ORDER BY p.tag;
+SELECT p.tag, b.v FROM probe p LEFT JOIN big b ON p.id = b.id ORDER BY p.tag;
+SELECT tag FROM probe WHERE id IN (SELECT id FROM big) ORDER BY tag;
+SELECT COUNT(*), SUM(c), MIN(c), MAX(c) FROM (SELECT g, COUNT(*) AS c FROM big GROUP BY g) q;
+SELECT g, COUNT(*), MIN(v), MAX(v) FROM big GROUP BY g ORDER BY g LIMIT 3;
+SELECT v, COUNT(*) FROM big GROUP BY v ORDER BY v LIMIT 2;
+RESET work_mem;
+SHOW work_mem;
+-- expected output:
+64kB
+late|v29999
+mid|v15000
+seven|v7
+late|v29999
+mid|v15000
+missing|
+null|
+seven|v7
+late
+mid
+seven
+3001|30001|1|10
+0|10|v12000|v9000
+1|10|v1|v9001
+2|10|v12002|v9002
+v1|1
+v10|1
+SET
+1GB
+-- expected status: 0